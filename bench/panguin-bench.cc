@@ -0,0 +1,197 @@
+///////////////////////////////////////////////////////////////////
+//  panguin-bench: benchmark of panguin's batch drawing path
+//
+//  panguin-bench data    -- write a synthetic analyzer-like ROOT file
+//  panguin-bench config  -- write a matching configuration
+//  panguin-bench run     -- time a configuration in batch mode
+//  panguin-bench all     -- generate both into a work directory and run
+//  panguin-bench check   -- like 'all', then compare with a baseline
+///////////////////////////////////////////////////////////////////
+
+#include "panguinBench.hh"
+#include "CLI11.hpp"
+#include <TROOT.h>
+#include <TSystem.h>
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+static void AddDataOptions( CLI::App* app, BenchDataSpec& data )
+{
+  app->add_option("-n,--entries", data.entries, "Entries per tree")
+    ->capture_default_str();
+  app->add_option("-b,--branches", data.branches, "Branches per tree")
+    ->capture_default_str();
+  app->add_option("-t,--trees", data.trees, "Number of trees")
+    ->capture_default_str();
+  app->add_option("--hists", data.hists, "Number of stored histograms")
+    ->capture_default_str();
+  app->add_option("-z,--compression", data.compression,
+                  "ROOT compression settings (algorithm*100 + level)")
+    ->capture_default_str();
+  app->add_option("--seed", data.seed, "Random number seed")
+    ->capture_default_str();
+}
+
+static void AddConfigOptions( CLI::App* app, BenchConfigSpec& cfg )
+{
+  app->add_option("-p,--pages", cfg.pages, "Number of pages")
+    ->capture_default_str();
+  app->add_option("-m,--pads", cfg.pads, "Pads per page")
+    ->capture_default_str();
+  app->add_flag("!--no-macros", cfg.macros, "Do not include macro pads");
+}
+
+static void AddRunOptions( CLI::App* app, BenchRunSpec& run )
+{
+  app->add_option("-N,--repeats", run.repeats, "Number of repetitions")
+    ->capture_default_str();
+  app->add_option("-O,--plots-dir", run.plotsdir,
+                  "Output directory for plots")
+    ->capture_default_str();
+  app->add_option("-o,--output", run.outfile,
+                  "JSON results file (\"-\" for stdout)")
+    ->capture_default_str();
+  app->add_flag("!--no-print", run.printpages, "Skip PrintPages stage");
+}
+
+static int WriteResult( const BenchResult& result, const BenchRunSpec& run )
+{
+  if( run.outfile == "-" )
+    return result.WriteJSON(cout, run);
+  ofstream ofs(run.outfile);
+  if( !ofs ) {
+    cerr << "ERROR: Cannot open results file " << run.outfile << endl;
+    return 1;
+  }
+  result.WriteJSON(ofs, run);
+  cerr << "Benchmark results written to " << run.outfile << endl;
+  return 0;
+}
+
+int main( int argc, char** argv )
+{
+  BenchDataSpec data;
+  BenchConfigSpec cfg;
+  BenchRunSpec run;
+  string workdir{"bench_work"};
+  string baseline{"bench_baseline.json"};
+  BenchTolerance tol;
+
+  CLI::App cli("panguin-bench: benchmark of panguin batch processing");
+  cli.require_subcommand(1);
+
+  auto* cdata = cli.add_subcommand("data", "Write synthetic ROOT file");
+  cdata->add_option("-f,--file", data.file, "Output ROOT file")
+    ->capture_default_str();
+  AddDataOptions(cdata, data);
+
+  auto* ccfg = cli.add_subcommand("config", "Write benchmark configuration");
+  ccfg->add_option("-f,--file", cfg.file, "Output configuration file")
+    ->capture_default_str();
+  ccfg->add_option("-R,--root-file", cfg.rootfile,
+                   "ROOT file for the configuration's 'rootfile' command");
+  ccfg->add_option("-b,--branches", cfg.branches,
+                   "Branches per tree in the data file")
+    ->capture_default_str();
+  ccfg->add_option("-t,--trees", cfg.trees, "Trees in the data file")
+    ->capture_default_str();
+  ccfg->add_option("--hists", cfg.hists, "Histograms in the data file")
+    ->capture_default_str();
+  AddConfigOptions(ccfg, cfg);
+
+  auto* crun = cli.add_subcommand("run", "Time a configuration in batch mode");
+  crun->add_option("-f,--config-file", run.cfgfile, "Configuration file")
+    ->capture_default_str();
+  crun->add_option("-R,--root-file", run.rootfile, "ROOT file to process");
+  AddRunOptions(crun, run);
+
+  auto* call = cli.add_subcommand("all",
+                                  "Generate data and configuration, then run");
+  call->add_option("-w,--work-dir", workdir,
+                   "Directory for generated files and plots")
+    ->capture_default_str();
+  AddDataOptions(call, data);
+  AddConfigOptions(call, cfg);
+  AddRunOptions(call, run);
+
+  auto* cchk = cli.add_subcommand("check",
+                                  "Like 'all', then compare with a baseline");
+  cchk->add_option("-w,--work-dir", workdir,
+                   "Directory for generated files and plots")
+    ->capture_default_str();
+  cchk->add_option("-B,--baseline", baseline,
+                   "Baseline results, written by 'all -o <file>'")
+    ->capture_default_str();
+  cchk->add_option("--time-tol", tol.time,
+                   "Allowed relative increase of stage times")
+    ->capture_default_str();
+  cchk->add_option("--time-abs", tol.time_abs,
+                   "Ignore time increases below this (s)")
+    ->capture_default_str();
+  cchk->add_option("--rss-tol", tol.rss,
+                   "Allowed relative increase of peak RSS")
+    ->capture_default_str();
+  cchk->add_option("--bytes-tol", tol.bytes,
+                   "Allowed relative increase of bytes read")
+    ->capture_default_str();
+  AddDataOptions(cchk, data);
+  AddConfigOptions(cchk, cfg);
+  AddRunOptions(cchk, run);
+
+  CLI11_PARSE(cli, argc, argv)
+
+  gROOT->SetBatch();
+  try {
+    if( cli.got_subcommand(cdata) )
+      return GenerateBenchData(data);
+    if( cli.got_subcommand(ccfg) )
+      return GenerateBenchConfig(cfg);
+    BenchResult base;
+    if( cli.got_subcommand(cchk) ) {
+      if( ReadBenchResult(baseline, base) ) {
+        cerr << "Create the baseline with \"panguin-bench all -o "
+             << baseline << "\" (or the bench-baseline build target)" << endl;
+        return 77;  // Skipped under ctest
+      }
+    }
+    if( cli.got_subcommand(call) || cli.got_subcommand(cchk) ) {
+      gSystem->mkdir(workdir.c_str(), true);
+      data.file = workdir + "/bench.root";
+      cfg.file = workdir + "/bench.cfg";
+      cfg.rootfile = data.file;
+      cfg.branches = data.branches;
+      cfg.trees = data.trees;
+      cfg.hists = data.hists;
+      run.cfgfile = cfg.file;
+      run.rootfile = data.file;
+      if( run.plotsdir == BenchRunSpec().plotsdir )
+        run.plotsdir = workdir + "/plots";
+      if( run.outfile == BenchRunSpec().outfile )
+        run.outfile = workdir + "/" + run.outfile;
+      if( GenerateBenchData(data) || GenerateBenchConfig(cfg) )
+        return 1;
+    }
+    BenchResult result;
+    if( RunBench(run, result) )
+      return 1;
+    if( WriteResult(result, run) )
+      return 1;
+    if( cli.got_subcommand(cchk) ) {
+      cout << "Comparison with baseline " << baseline << ":" << endl;
+      int nfail = CheckBench(base, result, tol, cout);
+      if( nfail > 0 ) {
+        cout << nfail << " performance regression(s) beyond tolerance" << endl;
+        return 1;
+      }
+      cout << "No performance regressions" << endl;
+    }
+    return 0;
+
+  } catch( const exception& e ) {
+    cerr << "Error while running panguin-bench: " << e.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,449 @@
+///////////////////////////////////////////////////////////////////
+//  panguin-bench: synthetic inputs and batch-mode timing
+///////////////////////////////////////////////////////////////////
+
+#include "panguinBench.hh"
+#include "panguinOnline.hh"
+#include "panguinMemory.hh"        // GetRSS
+#include "panguinOnlineConfig.hh"  // JsonQuote
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1D.h>
+#include <TH2D.h>
+#include <TRandom3.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <TROOT.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+using namespace std;
+
+//_____________________________________________________________________________
+double BenchTiming::Min() const
+{
+  return times.empty() ? 0 : *min_element(times.begin(), times.end());
+}
+
+//_____________________________________________________________________________
+double BenchTiming::Median() const
+{
+  if( times.empty() )
+    return 0;
+  vector<double> t(times);
+  sort(t.begin(), t.end());
+  size_t n = t.size();
+  return n % 2 ? t[n / 2] : 0.5 * (t[n / 2 - 1] + t[n / 2]);
+}
+
+//_____________________________________________________________________________
+const BenchTiming* BenchResult::Find( const string& name ) const
+{
+  for( const auto& st: stages ) {
+    if( st.name == name )
+      return &st;
+  }
+  for( const auto& pg: pages ) {
+    if( pg.name == name )
+      return &pg;
+  }
+  return nullptr;
+}
+
+//_____________________________________________________________________________
+string BenchTreeName( int itree )
+{
+  return itree == 0 ? string("T") : string(Form("T%d", itree));
+}
+
+//_____________________________________________________________________________
+// Branch 0 is the event number, branch 1 an error flag, the others are
+// "detector channels". Names in trees other than the first are prefixed
+// so that every branch name is unique in the file.
+string BenchBranchName( int itree, int ibr )
+{
+  string name;
+  if( ibr == 0 )
+    name = "CodaEventNumber";
+  else if( ibr == 1 )
+    name = "ErrorFlag";
+  else
+    name = Form("ch%d", ibr - 2);
+  if( itree > 0 )
+    name = Form("t%d_%s", itree, name.c_str());
+  return name;
+}
+
+//_____________________________________________________________________________
+int GenerateBenchData( const BenchDataSpec& spec )
+{
+  TFile f(spec.file.c_str(), "RECREATE", "panguin benchmark data",
+          spec.compression);
+  if( !f.IsOpen() ) {
+    cerr << "ERROR: Cannot create benchmark data file " << spec.file << endl;
+    return 1;
+  }
+  TRandom3 rng(spec.seed);
+  int nbr = max(spec.branches, 3);
+  vector<Double_t> vals(nbr);
+  for( int itree = 0; itree < max(spec.trees, 1); ++itree ) {
+    auto* tree = new TTree(BenchTreeName(itree).c_str(),
+                           "panguin benchmark tree");
+    for( int ibr = 0; ibr < nbr; ++ibr ) {
+      string name = BenchBranchName(itree, ibr);
+      tree->Branch(name.c_str(), &vals[ibr], (name + "/D").c_str());
+    }
+    for( Long64_t i = 0; i < spec.entries; ++i ) {
+      vals[0] = i;
+      vals[1] = rng.Rndm() < 0.01 ? 1 : 0;
+      for( int ibr = 2; ibr < nbr; ++ibr ) {
+        // Every other channel is correlated with its predecessor
+        double x = rng.Gaus(ibr, 1. + 0.1 * ibr);
+        vals[ibr] = (ibr % 2 == 1) ? 0.5 * vals[ibr - 1] + 0.5 * x : x;
+      }
+      tree->Fill();
+    }
+  }
+
+  Long64_t nfill = min(spec.entries, 100000LL);
+  for( int ih = 0; ih < spec.hists; ++ih ) {
+    string name = Form("hist_%03d", ih);
+    if( ih % 4 == 3 ) {
+      auto* h = new TH2D(name.c_str(), name.c_str(), 100, -5, 5, 100, -5, 5);
+      for( Long64_t i = 0; i < nfill; ++i )
+        h->Fill(rng.Gaus(0, 1), rng.Gaus(0, 1.5));
+    } else {
+      auto* h = new TH1D(name.c_str(), name.c_str(), 100, -5, 5);
+      for( Long64_t i = 0; i < nfill; ++i )
+        h->Fill(rng.Gaus(0.1 * ih - 1, 1));
+    }
+  }
+  f.Write();
+  f.Close();
+  return 0;
+}
+
+//_____________________________________________________________________________
+// Pads cycle through 1D tree variables, 1D with a defined cut, 2D
+// "colz" plots, profiles, variables from other trees, stored histograms
+// and (optionally) macros.
+int GenerateBenchConfig( const BenchConfigSpec& spec )
+{
+  ofstream ofs(spec.file);
+  if( !ofs ) {
+    cerr << "ERROR: Cannot create benchmark configuration " << spec.file << endl;
+    return 1;
+  }
+  string dir = DirnameStr(spec.file);
+  const string macroname = "bench_macro.C";
+  if( spec.macros ) {
+    ofstream mfs(dir + "/" + macroname);
+    if( !mfs ) {
+      cerr << "ERROR: Cannot create benchmark macro in " << dir << endl;
+      return 1;
+    }
+    mfs << "// Generated by panguin-bench" << endl
+        << "void bench_macro( int ich = 0 )" << endl
+        << "{" << endl
+        << "  TTree* t = nullptr;" << endl
+        << "  if( gFile ) gFile->GetObject(\"T\", t);" << endl
+        << "  if( t ) t->Draw(Form(\"ch%d\", ich), \"ErrorFlag==0\");" << endl
+        << "}" << endl;
+  }
+
+  int nch = max(spec.branches, 3) - 2;
+  int ntrees = max(spec.trees, 1);
+  int ncol = static_cast<int>(ceil(sqrt(static_cast<double>(spec.pads))));
+  int nrow = (spec.pads + ncol - 1) / ncol;
+
+  ofs << "# panguin benchmark configuration, generated by panguin-bench" << endl
+      << "# " << spec.pages << " pages x " << spec.pads << " pads" << endl;
+  if( !spec.rootfile.empty() )
+    ofs << "rootfile " << spec.rootfile << endl;
+  ofs << "definecut benchcut ErrorFlag==0&&CodaEventNumber>10" << endl
+      << endl;
+  int k = 0;
+  for( int ipage = 0; ipage < spec.pages; ++ipage ) {
+    ofs << "newpage " << ncol << " " << nrow << endl
+        << "\ttitle Benchmark page " << ipage + 1 << endl;
+    for( int ipad = 0; ipad < spec.pads; ++ipad, ++k ) {
+      string ch = BenchBranchName(0, 2 + k % nch);
+      string ch2 = BenchBranchName(0, 2 + (k + 1) % nch);
+      ofs << "\t";
+      switch( k % 8 ) {
+        case 0:
+        case 1:
+          ofs << ch;
+          break;
+        case 2:
+          ofs << ch << " benchcut -title \"" << ch << " with cut\"";
+          break;
+        case 3:
+          ofs << ch << ":" << ch2 << " -drawopt colz";
+          break;
+        case 4:
+          ofs << ch << ":CodaEventNumber -drawopt prof";
+          break;
+        case 5:
+          if( ntrees > 1 ) {
+            int itree = 1 + k % (ntrees - 1);
+            ofs << BenchBranchName(itree, 2 + k % nch)
+                << " -tree " << BenchTreeName(itree);
+          } else {
+            ofs << ch << " -logy";
+          }
+          break;
+        case 6:
+          if( spec.hists > 0 )
+            ofs << Form("hist_%03d", k % spec.hists);
+          else
+            ofs << ch;
+          break;
+        case 7:
+          if( spec.macros )
+            ofs << "macro " << macroname << "(" << k % nch << ")";
+          else
+            ofs << ch << " ErrorFlag==0";
+          break;
+      }
+      ofs << endl;
+    }
+    ofs << endl;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+using bench_clock = chrono::steady_clock;
+
+static double Seconds( bench_clock::time_point start )
+{
+  return chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+//_____________________________________________________________________________
+int RunBench( const BenchRunSpec& spec, BenchResult& result )
+{
+  result = BenchResult();
+  result.stages = {{"config_parse", {}}, {"open_scan", {}}};
+  if( spec.printpages )
+    result.stages.push_back({"print_pages", {}});
+
+  // Macros are looked up in the configuration's directory, as in panguin
+  string cfgdir = DirnameStr(spec.cfgfile);
+  TString macropath = gROOT->GetMacroPath();
+  if( !macropath.BeginsWith((cfgdir + ":").c_str()) )
+    gROOT->SetMacroPath((cfgdir + ":" + macropath.Data()).c_str());
+
+  for( int irep = 0; irep < max(spec.repeats, 1); ++irep ) {
+    OnlineConfig::CmdLineOpts opts(spec.cfgfile);
+    opts.rootfile = spec.rootfile;
+    opts.plotsdir = spec.plotsdir;
+    opts.printonly = true;
+
+    auto start = bench_clock::now();
+    OnlineConfig config(opts);
+    if( !config.ParseConfig() ) {
+      cerr << "ERROR: Cannot parse benchmark configuration "
+           << spec.cfgfile << endl;
+      return 1;
+    }
+    result.stages[0].times.push_back(Seconds(start));
+    UInt_t npages = config.GetPageCount();
+    if( result.pages.size() < npages ) {
+      for( UInt_t i = result.pages.size(); i < npages; ++i )
+        result.pages.push_back({Form("page_%u", i + 1), {}});
+    }
+
+    Long64_t bytes0 = TFile::GetFileBytesRead();
+    start = bench_clock::now();
+    OnlineGUI gui(std::move(config));
+    result.stages[1].times.push_back(Seconds(start));
+    result.peak_rss = max(result.peak_rss, MemoryAccount::GetRSS());
+
+    for( UInt_t i = 0; i < npages; ++i ) {
+      start = bench_clock::now();
+      gui.DrawPage(i);
+      result.pages[i].times.push_back(Seconds(start));
+      result.peak_rss = max(result.peak_rss, MemoryAccount::GetRSS());
+    }
+
+    if( spec.printpages ) {
+      start = bench_clock::now();
+      gui.PrintPages();
+      result.stages[2].times.push_back(Seconds(start));
+      result.peak_rss = max(result.peak_rss, MemoryAccount::GetRSS());
+    }
+    result.bytes_read = TFile::GetFileBytesRead() - bytes0;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+static void WriteTiming( ostream& os, const BenchTiming& t )
+{
+  os << "{\"name\": " << JsonQuote(t.name)
+     << ", \"min_ms\": " << 1e3 * t.Min()
+     << ", \"median_ms\": " << 1e3 * t.Median() << ", \"runs_ms\": [";
+  const char* sep = "";
+  for( auto s: t.times ) {
+    os << sep << 1e3 * s;
+    sep = ", ";
+  }
+  os << "]}";
+}
+
+//_____________________________________________________________________________
+int BenchResult::WriteJSON( ostream& os, const BenchRunSpec& spec ) const
+{
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  os << fixed << setprecision(3)
+     << "{" << endl
+     << "  \"config\": " << JsonQuote(spec.cfgfile) << "," << endl
+     << "  \"rootfile\": " << JsonQuote(spec.rootfile) << "," << endl
+     << "  \"repeats\": " << max(spec.repeats, 1) << "," << endl
+     << "  \"root_version\": " << JsonQuote(gROOT->GetVersion()) << "," << endl
+     << "  \"bytes_read\": " << bytes_read << "," << endl
+     << "  \"peak_rss_kb\": " << peak_rss << "," << endl
+     << "  \"stages\": [";
+  const char* sep = "";
+  for( const auto& st: stages ) {
+    os << sep << endl << "    ";
+    WriteTiming(os, st);
+    sep = ",";
+  }
+  os << endl << "  ]," << endl << "  \"pages\": [";
+  sep = "";
+  for( const auto& pg: pages ) {
+    os << sep << endl << "    ";
+    WriteTiming(os, pg);
+    sep = ",";
+  }
+  os << endl << "  ]" << endl << "}" << endl;
+  os.flags(flags);
+  os.precision(prec);
+  return 0;
+}
+
+//_____________________________________________________________________________
+// Value following "key": on 'line', or empty if not present
+static string JsonValue( const string& line, const string& key )
+{
+  string tag = "\"" + key + "\": ";
+  auto pos = line.find(tag);
+  if( pos == string::npos )
+    return {};
+  pos += tag.length();
+  if( line[pos] == '"' ) {
+    auto end = line.find('"', pos + 1);
+    return line.substr(pos + 1, end == string::npos ? end : end - pos - 1);
+  }
+  if( line[pos] == '[' ) {
+    auto end = line.find(']', pos);
+    return line.substr(pos + 1, end == string::npos ? end : end - pos - 1);
+  }
+  auto end = line.find_first_of(",}", pos);
+  return line.substr(pos, end == string::npos ? end : end - pos);
+}
+
+//_____________________________________________________________________________
+// Reads only the layout written by WriteJSON (one timing per line)
+int ReadBenchResult( const string& filename, BenchResult& result )
+{
+  ifstream ifs(filename);
+  if( !ifs ) {
+    cerr << "ERROR: Cannot open benchmark results file " << filename << endl;
+    return 1;
+  }
+  result = BenchResult();
+  vector<BenchTiming>* section = nullptr;
+  string line;
+  while( getline(ifs, line) ) {
+    if( line.find("\"stages\":") != string::npos ) {
+      section = &result.stages;
+    } else if( line.find("\"pages\":") != string::npos ) {
+      section = &result.pages;
+    } else if( section && line.find("\"name\":") != string::npos ) {
+      BenchTiming t;
+      t.name = JsonValue(line, "name");
+      string runs_ms = JsonValue(line, "runs_ms");
+      replace(runs_ms.begin(), runs_ms.end(), ',', ' ');
+      istringstream runs(runs_ms);
+      double ms;
+      while( runs >> ms )
+        t.times.push_back(1e-3 * ms);
+      section->push_back(t);
+    } else if( !section ) {
+      string val = JsonValue(line, "bytes_read");
+      if( !val.empty() )
+        result.bytes_read = stoll(val);
+      val = JsonValue(line, "peak_rss_kb");
+      if( !val.empty() )
+        result.peak_rss = stol(val);
+    }
+  }
+  if( result.stages.empty() ) {
+    cerr << "ERROR: No benchmark results found in " << filename << endl;
+    return 1;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+int CheckBench( const BenchResult& baseline, const BenchResult& current,
+                const BenchTolerance& tol, ostream& os )
+{
+  int nfail = 0;
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  os << fixed << setprecision(2)
+     << "  " << left << setw(16) << "quantity" << right
+     << setw(14) << "baseline" << setw(14) << "current"
+     << setw(9) << "ratio" << "  status" << endl;
+  auto row = [&]( const string& name, double base, double cur, double reltol,
+                  double abstol, const char* unit ) {
+    bool bad = cur > base * (1. + reltol) && cur - base > abstol;
+    double ratio = base > 0 ? cur / base : 0;
+    os << "  " << left << setw(16) << name << right
+       << setw(11) << base << " " << setw(2) << unit
+       << setw(11) << cur << " " << setw(2) << unit
+       << setw(9) << ratio << "  " << (bad ? "FAIL" : "ok") << endl;
+    if( bad )
+      ++nfail;
+  };
+
+  double base_total = 0, cur_total = 0;
+  vector<const vector<BenchTiming>*> sections{&baseline.stages, &baseline.pages};
+  for( const auto* section: sections ) {
+    for( const auto& b: *section ) {
+      const BenchTiming* c = current.Find(b.name);
+      if( !c ) {
+        os << "  " << left << setw(16) << b.name << right
+           << "  missing in current results" << endl;
+        ++nfail;
+        continue;
+      }
+      row(b.name, 1e3 * b.Min(), 1e3 * c->Min(), tol.time, 1e3 * tol.time_abs,
+          "ms");
+      if( section == &baseline.stages ) {
+        base_total += b.Min();
+        cur_total += c->Min();
+      }
+    }
+  }
+  row("total", 1e3 * base_total, 1e3 * cur_total, tol.time, 1e3 * tol.time_abs,
+      "ms");
+  row("peak_rss", baseline.peak_rss / 1024., current.peak_rss / 1024., tol.rss,
+      0, "MB");
+  row("bytes_read", baseline.bytes_read / 1048576., current.bytes_read / 1048576.,
+      tol.bytes, 0, "MB");
+  os.flags(flags);
+  os.precision(prec);
+  return nfail;
+}
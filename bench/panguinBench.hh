@@ -0,0 +1,88 @@
+#ifndef panguinBench_h
+#define panguinBench_h
+
+///////////////////////////////////////////////////////////////////
+//  panguin-bench
+//
+//  Generators for synthetic, analyzer-like ROOT files and matching
+//  panguin configurations, and a driver that times the stages of
+//  batch processing: configuration parsing, file open/metadata
+//  scan, the drawing of each page and a full PrintPages.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+struct BenchDataSpec {
+  std::string file{"bench.root"};
+  long long entries{100000};  // Entries per tree
+  int branches{20};           // Branches per tree, incl. event number & flag
+  int trees{1};               // Number of trees
+  int hists{10};              // Number of stored histograms
+  int compression{101};       // ROOT compression settings (algorithm*100+level)
+  unsigned int seed{4357};
+};
+
+struct BenchConfigSpec {
+  std::string file{"bench.cfg"};
+  std::string rootfile;       // ROOT file to reference in the configuration
+  int pages{5};
+  int pads{6};                // Pads per page
+  int branches{20};           // Must match the data file
+  int trees{1};
+  int hists{10};
+  bool macros{true};          // Include macro pads
+};
+
+struct BenchRunSpec {
+  std::string cfgfile{"bench.cfg"};
+  std::string rootfile;       // Overrides the configuration's rootfile
+  std::string plotsdir{"bench_plots"};
+  std::string outfile{"bench_results.json"};  // JSON results; "-" for stdout
+  int repeats{3};
+  bool printpages{true};
+};
+
+// Timing of one stage, over all repeats (seconds)
+struct BenchTiming {
+  std::string name;
+  std::vector<double> times;
+  double Min() const;
+  double Median() const;
+};
+
+struct BenchResult {
+  std::vector<BenchTiming> stages;  // parse, open, print
+  std::vector<BenchTiming> pages;   // one per page
+  long long bytes_read{0};          // Per repeat, from TFile::GetFileBytesRead
+  long peak_rss{0};                 // kB
+  int WriteJSON( std::ostream& os, const BenchRunSpec& spec ) const;
+  const BenchTiming* Find( const std::string& name ) const;
+};
+
+// Allowed increase relative to the baseline for a regression check.
+// Timing uses the fastest of the repeats. Times below 'time_abs' (in s)
+// are not considered, since they are dominated by noise.
+struct BenchTolerance {
+  double time{0.25};
+  double time_abs{0.005};
+  double rss{0.15};
+  double bytes{0.02};
+};
+
+// Branch name of branch 'ibr' (>=2) in tree 'itree'
+std::string BenchBranchName( int itree, int ibr );
+std::string BenchTreeName( int itree );
+
+int GenerateBenchData( const BenchDataSpec& spec );
+int GenerateBenchConfig( const BenchConfigSpec& spec );
+int RunBench( const BenchRunSpec& spec, BenchResult& result );
+// Read results written by BenchResult::WriteJSON
+int ReadBenchResult( const std::string& filename, BenchResult& result );
+// Compare 'current' with 'baseline' and print a per-stage table.
+// Returns the number of quantities exceeding their tolerance.
+int CheckBench( const BenchResult& baseline, const BenchResult& current,
+                const BenchTolerance& tol, std::ostream& os );
+
+#endif //panguinBench_h
@@ -0,0 +1,85 @@
+#ifndef panguinAlarm_h
+#define panguinAlarm_h
+
+///////////////////////////////////////////////////////////////////
+//  Alarms
+//
+//  Checks attached to pads with the -check pad option, evaluated
+//  in watchfile mode on every update for the pads of all pages,
+//  whether shown or not. A check compares one quantity of the
+//  pad's data with a threshold: the mean or RMS, the number of
+//  entries, the Kolmogorov-Smirnov probability with respect to the
+//  golden histogram, or the rate of new entries. The quantities of
+//  tree pads are accumulated over the entries added since the
+//  previous update, so that no entry is read twice.
+///////////////////////////////////////////////////////////////////
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Quantities of a pad that the checks are evaluated on. A negative ks or
+// rate means that it is not available.
+struct AlarmValues {
+  double entries{0};
+  double mean{0}, rms{0};
+  double ks{-1};
+  double rate{-1};       // New entries per second
+};
+
+class AlarmCheck {
+public:
+  // Parse a comma-separated list of checks, e.g. "mean=0:10,empty,ks=0.01".
+  // Returns false, with a message in 'error', on a syntax error.
+  static bool Parse( const std::string& list, std::vector<AlarmCheck>& checks,
+                     std::string& error );
+
+  // Description of the violation, or an empty string if the check passes
+  // or its quantity is not available
+  std::string Test( const AlarmValues& v ) const;
+  const std::string& GetSpec() const { return fSpec; }
+
+private:
+  enum EType { kMean, kRMS, kEmpty, kKS, kRate };
+  EType fType{kEmpty};
+  double fMin, fMax;     // Allowed range; fMin is the minimum KS probability
+  std::string fSpec;     // As written in the configuration
+};
+
+// Alarm state of one pad
+struct PadAlarm {
+  std::string spec;                  // Check list the state was built for
+  std::vector<AlarmCheck> checks;
+  AlarmValues values;
+  std::string source;                // Key state of the histogram evaluated,
+                                     // or UUID of the file of a tree
+  // Tree pads: entries processed, and the number and moments of the
+  // selected ones
+  long long treeEntries{-1};
+  double selected{0};
+  double sumw{0}, sumwx{0}, sumwx2{0};
+  // Rates: entries at the last two changes of the input, and their times,
+  // and at the previous evaluation
+  double lastEntries{-1}, lastTime{0};
+  double prevEntries{-1}, prevTime{0};
+  double evalEntries{-1}, evalTime{0};
+  std::vector<std::string> active;   // Checks failed at the last evaluation
+
+  // Update the rate for 'entries' selected at time 'now', evaluated every
+  // 'interval' seconds
+  void SetEntries( double entries, double now, double interval );
+  void Reset();
+};
+
+// Appends alarm transitions to a text file, opened on first use
+class AlarmLog {
+public:
+  void SetFile( const std::string& filename ) { fFileName = filename; }
+  void Write( const std::string& line );
+
+private:
+  std::string fFileName;
+  std::ofstream fOut;
+};
+
+#endif //panguinAlarm_h
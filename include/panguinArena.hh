@@ -0,0 +1,53 @@
+#ifndef panguinArena_h
+#define panguinArena_h
+
+///////////////////////////////////////////////////////////////////
+//  PadArena
+//
+//  Owns the ROOT objects panguin creates while drawing (histograms
+//  from TTree::Draw, error message boxes, etc.), organized by page
+//  and pad. Adopted objects are detached from any directory and
+//  will not be deleted by the pad that displays them. They are
+//  released (deleted) explicitly, normally right after the pad or
+//  canvas has been cleared for the next update, so that memory
+//  use stays flat however long the program runs.
+///////////////////////////////////////////////////////////////////
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class TObject;
+
+class PadArena {
+public:
+  PadArena() = default;
+  PadArena( const PadArena& ) = delete;
+  PadArena& operator=( const PadArena& ) = delete;
+  ~PadArena();
+
+  // Take ownership of 'obj', drawn in the given pad of the given page.
+  // Returns 'obj'. Adopting an object twice has no effect.
+  template<typename T> T* Adopt( int page, int pad, T* obj )
+  {
+    AdoptObject(page, pad, obj);
+    return obj;
+  }
+  void Release( int page, int pad );
+  void ReleasePage( int page );
+  void ReleaseAll();
+
+  size_t GetSize() const;
+  size_t GetSize( int page, int pad ) const;
+  // Objects owned for the given pad (nullptr if none)
+  const std::vector<std::unique_ptr<TObject>>* Get( int page, int pad ) const;
+
+private:
+  using key_t = std::pair<int, int>;  // page, pad
+  std::map<key_t, std::vector<std::unique_ptr<TObject>>> fObjects;
+
+  void AdoptObject( int page, int pad, TObject* obj );
+};
+
+#endif //panguinArena_h
@@ -0,0 +1,72 @@
+#ifndef panguinCanvasPool_h
+#define panguinCanvasPool_h
+
+///////////////////////////////////////////////////////////////////
+//  CanvasPool
+//
+//  Off-screen (batch) canvases for saving images and printing pages,
+//  kept by size and reused instead of being created and destroyed
+//  for every output. A canvas is handed out as a Lease, which
+//  returns it, cleared, to the pool when released. Acquiring and
+//  releasing are thread-safe, so that several workers can save
+//  images at the same time, each on its own canvas.
+///////////////////////////////////////////////////////////////////
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <cstddef>
+
+class TCanvas;
+
+class CanvasPool {
+public:
+  class Lease {
+  public:
+    Lease() = default;
+    Lease( Lease&& rhs ) noexcept;
+    Lease& operator=( Lease&& rhs ) noexcept;
+    Lease( const Lease& ) = delete;
+    Lease& operator=( const Lease& ) = delete;
+    ~Lease() { reset(); }
+
+    TCanvas* get() const { return fCanvas; }
+    TCanvas* operator->() const { return fCanvas; }
+    explicit operator bool() const { return fCanvas != nullptr; }
+    void reset();
+
+  private:
+    friend class CanvasPool;
+    Lease( CanvasPool* pool, TCanvas* canvas, unsigned int w, unsigned int h )
+      : fPool(pool), fCanvas(canvas), fWidth(w), fHeight(h) {}
+    CanvasPool* fPool{nullptr};
+    TCanvas* fCanvas{nullptr};
+    unsigned int fWidth{0};
+    unsigned int fHeight{0};
+  };
+
+  // At most 'maxidle' unused canvases are kept per size
+  explicit CanvasPool( size_t maxidle = 4 ) : fMaxIdle(maxidle) {}
+  ~CanvasPool();
+  CanvasPool( const CanvasPool& ) = delete;
+  CanvasPool& operator=( const CanvasPool& ) = delete;
+
+  // Empty batch canvas of the given size (in pixels), made current
+  Lease Acquire( unsigned int width, unsigned int height );
+
+  unsigned long GetCreated() const { return fCreated; }
+  unsigned long GetReused() const { return fReused; }
+
+private:
+  using key_t = std::pair<unsigned int, unsigned int>;  // width, height
+  void Release( TCanvas* canvas, const key_t& key );
+
+  std::mutex fMutex;
+  std::map<key_t, std::vector<TCanvas*>> fIdle;
+  size_t fMaxIdle;
+  unsigned long fCreated{0};
+  unsigned long fReused{0};
+};
+
+#endif //panguinCanvasPool_h
@@ -0,0 +1,59 @@
+#ifndef panguinCompare_h
+#define panguinCompare_h
+
+///////////////////////////////////////////////////////////////////
+//  Statistical comparison of histograms with their golden
+//  (reference) counterparts. Used by panguin's --compare mode.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+class TH1;
+
+struct CompareResult {
+  std::string name;          // Histogram name
+  std::string type;          // Histogram class name
+  double entries{0};         // Entries in current histogram
+  double golden_entries{0};  // Entries in golden histogram
+  double ks{-1};             // Kolmogorov-Smirnov probability
+  double chi2{-1};           // Chi2 (unweighted/unweighted)
+  int ndf{0};                // Degrees of freedom of chi2 test
+  double chi2prob{-1};       // Chi2 probability
+  double normdiff{-1};       // Normalized difference (0 = same, 1 = disjoint)
+  std::string status;        // "ok" or reason why comparison failed
+
+  bool IsOk() const { return status == "ok"; }
+  double Score() const;      // Agreement score. Lower is worse.
+};
+
+class GoldenCompare {
+public:
+  explicit GoldenCompare( bool do_normdiff = false, unsigned int nthreads = 0 );
+
+  // Queue a histogram pair. The histograms are not owned, but must remain
+  // valid until Run() returns. They must not be attached to a directory
+  // that is modified concurrently.
+  void Add( const std::string& name, const TH1* hist, const TH1* golden );
+  void Run();
+  const std::vector<CompareResult>& GetResults() const { return fResults; }
+  int  WriteReport( const std::string& filename ) const;
+  int  WriteCSV( std::ostream& os ) const;
+  int  WriteJSON( std::ostream& os ) const;
+
+private:
+  struct Pair {
+    std::string name;
+    const TH1* hist;
+    const TH1* golden;
+  };
+  bool fDoNormDiff;
+  unsigned int fNthreads;
+  std::vector<Pair> fPairs;
+  std::vector<CompareResult> fResults;
+
+  CompareResult Compare( const Pair& p ) const;
+};
+
+#endif //panguinCompare_h
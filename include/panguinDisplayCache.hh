@@ -0,0 +1,71 @@
+#ifndef panguinDisplayCache_h
+#define panguinDisplayCache_h
+
+///////////////////////////////////////////////////////////////////
+//  DisplayCache
+//
+//  Display copies of very large 1D and 2D histograms. A histogram
+//  with more bins than a set limit is painted through a copy with
+//  about as many bins as the pad has pixels, grouped like
+//  TH1::Rebin, while the full-resolution histogram is kept for
+//  everything else (statistics, trends, comparisons). The copy of
+//  each pad is kept and rebuilt only when the data or the pad size
+//  change. When the pad is zoomed, the copy is rebuilt at the
+//  resolution of the visible range, down to the original bins.
+//  The rebuild replaces the object the pad paints, so it must not
+//  be done while the pad is being painted.
+///////////////////////////////////////////////////////////////////
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TH1;
+class TVirtualPad;
+
+class DisplayCache {
+public:
+  // Histograms with more cells than this get a display copy; 0 disables
+  void SetMaxBins( long long maxbins ) { fMaxBins = maxbins; }
+  bool IsEnabled() const { return fMaxBins > 0; }
+
+  // If 'hist', drawn in 'pad' of page 'page', is large enough, draw its
+  // display copy in its place. Returns the copy, or nullptr if 'hist' is
+  // drawn as it is.
+  TH1* Replace( TVirtualPad* pad, int page, TH1* hist );
+  // Whether the visible range of the display copy in 'pad' differs from
+  // the range it was built for. Does not change anything.
+  bool RangeChanged( TVirtualPad* pad, int page ) const;
+  // Rebuild the display copy in 'pad' for the visible range of its axes.
+  // Returns true if the pad was changed. Not to be called during a paint.
+  bool Zoom( TVirtualPad* pad, int page );
+
+  // Full-resolution histogram shown through the copy in 'pad', or nullptr
+  // if the pad no longer displays the copy
+  TH1* GetFull( TVirtualPad* pad, int page ) const;
+  // Forget the full-resolution histogram of a pad, e.g. before it is deleted
+  void Drop( int page, int pad );
+
+  void Clear() { fEntries.clear(); }
+
+private:
+  struct Entry {
+    std::string sig;               // Data and pad size of 'display'
+    std::unique_ptr<TH1> display;
+    TH1* full{nullptr};            // Owned by the pad's arena
+    std::vector<int> xmap, ymap;   // Display bin of each full bin
+    int px{0}, py{0};              // Plot area size in pixels
+    int range[4]{};                // Display axis bins shown when built
+    bool zoomed{false};            // Built for part of the full range
+  };
+  std::map<std::pair<int, int>, Entry> fEntries;
+  long long fMaxBins{0};
+
+  static void GetRange( const TH1* display, int range[4] );
+  static TH1* MakeDisplay( const TH1* full, int xfirst, int xlast,
+                           int yfirst, int ylast, Entry& e );
+};
+
+#endif //panguinDisplayCache_h
@@ -0,0 +1,78 @@
+#ifndef panguinIOStats_h
+#define panguinIOStats_h
+
+///////////////////////////////////////////////////////////////////
+//  IOStats
+//
+//  Attaches a TTreePerfStats to the tree for the duration of each
+//  TTree::Draw and collects what was read: bytes, baskets and read
+//  calls, unzip and disk time per pad, and bytes and baskets per
+//  branch. Reports per pad and aggregated per page. Optionally,
+//  the TTreePerfStats objects are saved to a ROOT file.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <utility>
+#include <iosfwd>
+
+class TTree;
+class TTreePerfStats;
+class TVirtualPerfStats;
+
+struct BranchIO {
+  std::string name;
+  long long bytes{0};        // Compressed bytes of baskets read
+  int baskets{0};            // Number of baskets read
+};
+
+struct PadIO {
+  int page{-1};
+  int pad{0};
+  std::string name;          // Variable drawn
+  std::string tree;          // Tree drawn from
+  long long bytes{0};        // Bytes read from file
+  long long readcalls{0};    // Read calls to the file
+  int baskets{0};            // Baskets read, all branches
+  double unziptime{0};       // Decompression time (s)
+  double disktime{0};        // Time spent reading the file (s)
+  double realtime{0};        // Wall time of the draw (s)
+  std::vector<BranchIO> branches;  // Branches with baskets read
+};
+
+class IOStats {
+public:
+  IOStats();
+  ~IOStats();
+  IOStats( const IOStats& ) = delete;
+  IOStats& operator=( const IOStats& ) = delete;
+
+  // Enable collection. If 'savefile' is not empty, the TTreePerfStats
+  // objects are kept and written to that ROOT file by Finish().
+  void Enable( const std::string& savefile = std::string() );
+  bool IsEnabled() const { return fEnabled; }
+
+  // Start/stop monitoring 'tree' for a draw in the given pad
+  void Begin( TTree* tree, int page, int pad, const std::string& name );
+  void End();
+
+  void PrintPage( std::ostream& os, int page ) const;
+  void PrintSummary( std::ostream& os ) const;
+  int  Finish();
+
+private:
+  using key_t = std::pair<int, int>;  // page, pad
+  bool fEnabled{false};
+  std::string fSaveFile;
+  std::map<key_t, PadIO> fPads;       // Most recent draw of each pad
+  std::map<key_t, std::unique_ptr<TTreePerfStats>> fSaved;
+  // Draw in progress
+  TTree* fTree{nullptr};
+  std::unique_ptr<TTreePerfStats> fStats;
+  TVirtualPerfStats* fPrevStats{nullptr};
+  PadIO fCurrent;
+};
+
+#endif //panguinIOStats_h
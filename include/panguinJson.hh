@@ -0,0 +1,71 @@
+#ifndef panguinJson_h
+#define panguinJson_h
+
+///////////////////////////////////////////////////////////////////
+//  JsonOutput
+//
+//  Writes each drawn pad as ROOT JSON (TBufferJSON), which JSROOT
+//  can display directly, and a manifest listing the pages and pads.
+//  Only pads whose JSON differs from the previous update are
+//  written again. Each update that changes anything increments a
+//  sequence number, recorded in the manifest for the update and
+//  for every pad written, so that a client can poll the manifest
+//  and fetch only the pads that changed. Files are replaced
+//  atomically.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+class TVirtualPad;
+
+class JsonOutput {
+public:
+  JsonOutput() = default;
+  JsonOutput( const JsonOutput& ) = delete;
+  JsonOutput& operator=( const JsonOutput& ) = delete;
+
+  // Enable output to 'dir'. Changing the directory starts a new manifest,
+  // but the sequence number keeps counting.
+  void SetDirectory( const std::string& dir );
+  bool IsEnabled() const { return !fDir.empty(); }
+
+  void BeginPage( int page, const std::string& title, int nx, int ny,
+                  int run );
+  // Serialize 'pad' (after painting). Written only if it changed.
+  void AddPad( int pad, const std::string& name, TVirtualPad* vpad );
+  // Write the manifest if anything changed. Returns the number of pads
+  // written for this page.
+  int  EndPage();
+
+  unsigned long GetSeq() const { return fSeq; }
+
+private:
+  struct PadEntry {
+    std::string name;
+    std::string file;
+    std::size_t hash{0};
+    unsigned long seq{0};
+  };
+  struct PageEntry {
+    std::string title;
+    int nx{0}, ny{0};
+    unsigned long seq{0};
+    std::map<int, PadEntry> pads;
+  };
+  std::string fDir;
+  std::map<int, PageEntry> fPages;
+  unsigned long fSeq{0};
+  int fRun{0};
+  // Page in progress
+  int fPage{-1};
+  int fWritten{0};
+  bool fChanged{false};
+
+  int WriteFile( const std::string& name, const std::string& content ) const;
+  int WriteManifest() const;
+};
+
+#endif //panguinJson_h
@@ -0,0 +1,52 @@
+#ifndef panguinManifest_h
+#define panguinManifest_h
+
+///////////////////////////////////////////////////////////////////
+//  OutputManifest
+//
+//  Content digests of the images and plot pages written, kept in a
+//  manifest file across updates and invocations. An output whose
+//  digest is unchanged, and which still exists, need not be
+//  rendered or written again. Counts written and skipped outputs.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <map>
+#include <iosfwd>
+
+class TObject;
+
+class OutputManifest {
+public:
+  OutputManifest() = default;
+  OutputManifest( const OutputManifest& ) = delete;
+  OutputManifest& operator=( const OutputManifest& ) = delete;
+
+  // Enable, reading any existing manifest 'filename'
+  void SetFile( const std::string& filename );
+  bool IsEnabled() const { return !fFileName.empty(); }
+
+  // Digest of the persistent state of 'obj' (as ROOT JSON) and of 'extra',
+  // e.g. draw options
+  static std::string Digest( const TObject* obj,
+                             const std::string& extra = std::string() );
+
+  // True if 'path' exists and was written with content 'digest'. Counted
+  // as skipped.
+  bool IsUnchanged( const std::string& path, const std::string& digest );
+  // Record that 'path' was written with content 'digest'
+  void Update( const std::string& path, const std::string& digest );
+
+  // Write the manifest if it changed. Returns 1 on error.
+  int  Save();
+  void PrintSummary( std::ostream& os ) const;
+
+private:
+  std::string fFileName;
+  std::map<std::string, std::string> fDigests;  // Output path -> digest
+  bool fDirty{false};
+  int fWritten{0};
+  int fSkipped{0};
+};
+
+#endif //panguinManifest_h
@@ -0,0 +1,80 @@
+#ifndef panguinMemory_h
+#define panguinMemory_h
+
+///////////////////////////////////////////////////////////////////
+//  MemoryAccount
+//
+//  Bookkeeping of the memory used by each pad while a page is
+//  drawn: histogram storage, TTree::Draw value buffers, entry
+//  lists and the tree's basket (read) cache, plus the resident
+//  memory of the process sampled around every pad. Byte counts
+//  are estimates from the objects' sizes, not allocator statistics.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iosfwd>
+
+class TObject;
+class TH1;
+class TTree;
+class TVirtualPad;
+
+struct PadMemory {
+  int pad{0};
+  std::string name;          // Variable, histogram or macro drawn
+  long long hists{0};        // Bytes in histograms displayed in the pad
+  long long drawbuf{0};      // Bytes in TTree::Draw value buffers
+  long long entrylists{0};   // Bytes in entry/event lists
+  long long cache{0};        // Basket cache size of the tree drawn from
+  long rss_before{0};        // Resident memory (kB) before drawing the pad
+  long rss_after{0};         // Resident memory (kB) after drawing the pad
+
+  long long Total() const { return hists + drawbuf + entrylists + cache; }
+};
+
+struct PageMemory {
+  int page{-1};
+  std::string title;
+  std::vector<PadMemory> pads;
+  long rss_start{0};         // Resident memory (kB) when page draw started
+  long rss_end{0};           // Resident memory (kB) when page draw ended
+  long rss_peak{0};          // Largest resident memory (kB) seen during draw
+
+  long long Total() const;
+};
+
+class MemoryAccount {
+public:
+  void BeginPage( int page, const std::string& title );
+  void BeginPad( int pad, const std::string& name );
+  void EndPad( TVirtualPad* pad );
+  void EndPage();
+  // Pad currently being drawn (nullptr outside of BeginPad/EndPad)
+  PadMemory* CurrentPad();
+  void Clear();
+
+  const PageMemory* GetPage( int page ) const;
+  long GetPeakRSS() const { return fPeakRSS; }
+
+  void Print( std::ostream& os, const PageMemory& page ) const;
+  void PrintSummary( std::ostream& os ) const;
+  int  WriteJSON( const std::string& filename ) const;
+
+  static long      GetRSS();
+  static long long HistBytes( const TH1* hist );
+  static long long PadHistBytes( TVirtualPad* pad );
+  static long long DrawBufferBytes( TTree* tree );
+  static long long EntryListBytes( const TObject* obj );
+
+private:
+  std::map<int, PageMemory> fPages;  // Most recent draw of each page
+  PageMemory fCurrent;
+  bool fInPad{false};
+  long fPeakRSS{0};
+
+  void Sample( long rss );
+};
+
+#endif //panguinMemory_h
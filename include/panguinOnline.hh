@@ -5,16 +5,20 @@
 #define panguinOnline_h 1
 
 #include <TTree.h>
+#include <TChain.h>
 #include <TFile.h>
+#include <TMapFile.h>
 #include <TGButton.h>
 #include <TGFrame.h>
 #include <TGListBox.h>
 #include <TRootEmbeddedCanvas.h>
+#include <TCanvas.h>
 #include "TGLabel.h"
 #include "TGString.h"
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
 #include <TString.h>
 #include <TCut.h>
 #include <TTimer.h>
@@ -22,8 +26,21 @@
 #include "TH2.h"
 #include "TH3.h"
 #include "panguinOnlineConfig.hh"
+#include "panguinArena.hh"
+#include "panguinMemory.hh"
+#include "panguinProfile.hh"
+#include "panguinIOStats.hh"
+#include "panguinJson.hh"
+#include "panguinSnapshot.hh"
+#include "panguinManifest.hh"
+#include "panguinCanvasPool.hh"
+#include "panguinTrend.hh"
+#include "panguinStripChart.hh"
+#include "panguinDisplayCache.hh"
+#include "panguinAlarm.hh"
 
 #define UPDATETIME 10000
+#define MAPUPDATETIME 500
 
 class OnlineGUI {
   TGMainFrame* fMain = nullptr;
@@ -43,11 +60,15 @@ class OnlineGUI {
   TGLabel* fRunNumber = nullptr;
   TGTextButton* fPrint = nullptr;
   TCanvas* fCanvas = nullptr; // Present Embedded canvas
+  CanvasPool fCanvasPool; //! Off-screen canvases for images and pages
+  CanvasPool::Lease fPrintCanvas; //! Canvas for batch mode
   OnlineConfig fConfig;
   Int_t current_page;
   Int_t current_pad;
   TFile* fRootFile = nullptr;
   TFile* fGoldenFile = nullptr;
+  TFile* fGoldenTreeFile = nullptr;  // Golden tree-draw results, keyed by pad
+  TMapFile* fMapFile = nullptr;      // Live histograms of a producer (--map-file)
   Bool_t doGolden;
   std::vector<TTree*> fRootTree;
   std::vector<Int_t> fTreeEntries;
@@ -56,22 +77,83 @@ class OnlineGUI {
   Int_t runNumber;
   TTimer* timer = nullptr;
   TTimer* timerNow = nullptr; // used to update time
+  TTimer* fZoomTimer = nullptr; // Rebuilds a zoomed display copy after the paint
+  Int_t fZoomPad{0};            // Pad to rebuild
   Bool_t fUpdate;
   Bool_t fFileAlive;
   Bool_t fPrintOnly;
   Bool_t fSaveImages;
+  std::string fImageFile;  // Image requested for the pad being drawn
   TH1* mytemp1d = nullptr;
   TH2* mytemp2d = nullptr;
   TH3* mytemp3d = nullptr;
   TH1* mytemp1d_golden = nullptr;
   //TH2* mytemp2d_golden = nullptr;
   TH3* mytemp3d_golden = nullptr;
+  // Golden histograms, read once and detached from fGoldenFile
+  std::map<std::string, std::unique_ptr<TH1>> fGoldenCache; //!
+  std::map<std::string, std::unique_ptr<TH1>> fGoldenTreeCache; //!
+  // Multi-segment runs: segments after the first (fRootFile), the trees
+  // chained over all segments, and results for the completed segments
+  std::vector<std::unique_ptr<TFile>> fSegmentFiles; //!
+  std::vector<std::unique_ptr<TChain>> fChains; //!
+  std::string fSegmentRun;  // Name and UUID of the first segment
+  struct SegmentSum {
+    size_t nseg{0};                  // Segments summed, from the first
+    std::unique_ptr<TH1> hist;
+  };
+  struct SegmentDraw {
+    Long64_t entries{0};             // Chain entries processed, from the first
+    std::unique_ptr<TH1> hist;
+    Bool_t full{kFALSE};             // Range not stable: always draw everything
+  };
+  std::map<std::string, SegmentSum> fSegmentHists; //!
+  std::map<std::string, SegmentDraw> fSegmentDraws; //!
+  MemoryAccount fMemory; //! Memory used per page and pad
+  mutable Profiler fProfiler; //! Timing of processing stages (--profile)
+  IOStats fIOStats; //! Tree I/O statistics per pad (--io-stats)
+  PadArena fArena; //! Objects created while drawing, owned per page/pad
+  JsonOutput fJson; //! Pads as ROOT JSON (--json-dir)
+  HistSnapshot fSnapshot; //! Saved tree-draw results (--snapshot)
+  mutable OutputManifest fManifest; //! Digests of outputs (--output-manifest)
+  TrendStore fTrend; //! Per-run pad metrics (--trend-file)
+  Bool_t fRecordTrend{kFALSE}; // Record pad metrics while printing pages
+  // Per-update metrics of the stripchart pads, by page and pad
+  std::map<std::pair<Int_t, Int_t>, StripChart> fStripCharts; //!
+  DisplayCache fDisplay; //! Rebinned display copies of large histograms
+  // Watchfile updates: redraw only the pads whose inputs changed since the
+  // page was drawn (fDrawnPage), as recorded per pad in fPadInputs
+  Bool_t fOnlyChanged{kFALSE};
+  Int_t fDrawnPage{-1};
+  std::map<Int_t, std::string> fPadInputs; //!
+  // Pad checks (-check), by page and pad, and the alarms per page
+  std::map<std::pair<Int_t, Int_t>, PadAlarm> fAlarms; //!
+  std::vector<Int_t> fPageAlarms; //!
+  AlarmLog fAlarmLog; //! Alarms raised and cleared (--alarm-log)
 
   int fVerbosity;
 
   std::string SubstitutePlaceholders(
     std::string str, const std::string& var = std::string() ) const;
+  TCut GetDrawCut( const std::map<std::string, std::string>& command );
+  TString GetPadIdentity( const std::map<std::string, std::string>& command );
+  void DrawGoldenTree( TH1* hist, const std::map<std::string, std::string>& command );
   void DeleteGUI();
+  std::string GetInputIdentity() const;
+  void OpenSnapshot();
+  TCanvas* GetPrintCanvas();
+
+  // Outcome of printing one run of a multi-run job or the daemon
+  struct RunTiming {
+    Int_t run;
+    Double_t open;     // s
+    Double_t print;    // s
+    std::string status;
+    Bool_t IsOK() const { return status == "ok"; }
+  };
+  RunTiming PrintRun( Int_t run, Bool_t& openGolden,
+                      const std::string& filename = std::string() );
+  void CheckRunPlaceholder() const;
 
 public:
   using cmdmap_t = std::map<std::string, std::string>;
@@ -79,6 +161,7 @@ public:
   void CreateGUI( const TGWindow* p, UInt_t w, UInt_t h );
   virtual ~OnlineGUI();
   void DoDraw();
+  void DrawPage( Int_t page );
   void DrawPrev();
   void DrawNext();
   void DoListBox( Int_t id );
@@ -86,27 +169,65 @@ public:
   // Specific Draw Methods
   Bool_t IsHistogram( const TString& objectname );
   Bool_t IsPrintOnly() const { return fPrintOnly; }
+  Bool_t IsCompare() const { return fConfig.DoCompare(); }
+  Bool_t IsMakeGoldenTrees() const { return fConfig.DoMakeGoldenTrees(); }
+  Bool_t IsSoakTest() const { return fConfig.GetSoakUpdates() > 0; }
   void GetFileObjects();
   void GetTreeVars();
   void GetRootTree();
   UInt_t GetTreeIndex( const TString& );
   UInt_t GetTreeIndexFromName( const TString& );
-  void TreeDraw( const cmdmap_t& command );
-  void HistDraw( const cmdmap_t& command );
+  TH1* GetGoldenHist( const std::string& name );
+  TH1* TreeDraw( const cmdmap_t& command );
+  TString ScatterMode( const cmdmap_t& command, TTree* tree,
+                       const TString& var, std::string& opt, TCut& cut );
+  void DrawScatterNote( const TString& note );
+  Long64_t BoundedTreeDraw( TTree* tree, const TString& var, const TCut& cut,
+                            const std::string& opt );
+  Long64_t SegmentTreeDraw( TChain* chain, const TString& var, const TCut& cut,
+                            const std::string& opt, const TString& hname );
+  TH1* GetRunHist( const TString& name );
+  void OpenSegments( Bool_t rescan );
+  TH1* HistDraw( const cmdmap_t& command );
+  void TrendDraw( const cmdmap_t& command );
+  void StripChartDraw( const cmdmap_t& command );
+  void UpdateStripCharts();
+  void UpdateAlarms();
+  Bool_t EvalHistAlarm( const std::string& name, PadAlarm& alarm, double now );
+  Bool_t EvalTreeAlarm( const cmdmap_t& command, PadAlarm& alarm, double now );
+  void LogAlarms( Int_t page, Int_t pad, const std::string& name,
+                  const PadAlarm& alarm, const std::vector<std::string>& active );
+  void ShowPageAlarms();
   void MacroDraw( const cmdmap_t& command );
   void LoadDraw( const cmdmap_t& command );
   void LoadLib( const cmdmap_t& command );
-  void SaveImage( TObject* o, const cmdmap_t& command ) const;
-  void SaveMacroImage( const cmdmap_t& drawcommand );
+  void SaveImage( const cmdmap_t& command );
+  void SavePadImage( const cmdmap_t& command );
+  void UseDisplayCopy( TH1* hist, const cmdmap_t& command );
+  std::string GetPadInputs( const cmdmap_t& command );
+  std::string GetHistKeyState( const std::string& name );
+  void KeepPadHists();
+  void DisplayZoomed();
+  void ApplyZoom();
   void DoDrawClear();
   void TimerUpdate();
+  Int_t GetUpdateInterval() const;
   void UpdateCurrentTime();  // update current time
-  static void BadDraw( const TString& );
+  void BadDraw( const TString& );
   void CheckRootFile();
   Int_t OpenRootFile();
-  Int_t PrepareRootFiles();
+  Int_t OpenMapFile();
+  Int_t PrepareRootFiles( Bool_t openGolden = kTRUE );
+  Bool_t ParallelOpen();
   void PrintToFile();
   void PrintPages();
+  Int_t PrintRuns();
+  Int_t RunDaemon( const std::string& statefile, Int_t interval,
+                   Int_t settle, Int_t firstrun );
+  void CompareGolden();
+  void BuildGoldenTreeCache();
+  void SoakTest( Int_t nupdates );
+  void WriteMemoryReport() const;
   void MyCloseWindow();
   void CloseGUI();
   void SetVerbosity( int ver ) { fVerbosity = ver; }
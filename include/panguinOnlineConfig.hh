@@ -20,6 +20,9 @@ using PageInfo_t = std::vector<std::pair<uint_t, uint_t>>;
 std::string ReplaceAll(
   std::string str, const std::string& ostr, const std::string& nstr );
 bool EndsWith( const std::string& str, const std::string& tail );
+std::string JsonQuote( const std::string& str );
+std::string CsvQuote( const std::string& str );
+std::string HashDigest( const std::string& data );
 
 class OnlineConfig {
   // Class that takes care of the config file
@@ -38,9 +41,23 @@ class OnlineConfig {
   std::string fImageFormat;       // File format for saved image files (default: png)
   std::string fImagesDir;         // Where to save individual images
   std::string plotsdir;           // Where to save plots
+  std::string fCompareFile;       // Golden comparison report (--compare)
+  std::string fGoldenTreeFile;    // Golden tree-draw results, keyed by pad
+  std::string fMemoryReportFile;  // Per-pad memory use (--memory-report)
+  std::string fProfileFile;       // Timing trace output (--profile)
+  std::string fIOStatsFile;       // Saved TTreePerfStats (--io-stats-file)
+  std::string fJsonDir;           // JSON output of pads (--json-dir)
+  std::string fSnapshotFile;      // Saved tree-draw results (--snapshot)
+  std::string fOutputManifest;    // Digests of written outputs (--output-manifest)
+  std::string fTrendFile;         // Per-run pad metrics (--trend-file)
+  std::string fMapFile;           // Shared-memory input (--map-file)
+  std::string fAlarmLog;          // Log of pad check alarms (--alarm-log)
   // the config file, in memory
   ConfLines_t sConfFile;
   VecStr_t    fProtoRootFiles; // Candidate ROOT file names
+  std::vector<int> fRuns;      // Runs to process in one batch job
+  std::vector<double> fTrendQuantiles; // Quantiles recorded in the trend store
+  VecStr_t    fRootSegments;   // All segments of the run, in order
   // pageInfo is the vector of the pages containing the sConfFile index
   //   and how many commands issued within that page (title, 1d, etc.)
   PageInfo_t  pageInfo;
@@ -54,9 +71,19 @@ class OnlineConfig {
   int fRunNoWidth;
   int fPageNoWidth;
   int fPadNoWidth;
+  int fSoakUpdates;
+  int fUpdateInterval;  // Watchfile update interval in ms, 0 for default
+  long long fDisplayMaxBins;  // Larger histograms are drawn rebinned
+  long long fScatterMaxPoints;  // Larger scatter plots use density mode
+  long long fDrawBuffer;  // Entries buffered by multi-dimensional tree draws
   bool fPrintOnly;
   bool fSaveImages;
+  bool fCompareNormDiff;
+  bool fMakeGoldenTrees;
+  bool fIOStats;
+  bool fDaemon;
 
+  std::string GetRootFilesSearchPath() const;
   int LoadFile( std::ifstream& infile, const std::string& filename );
   int CheckLoadIncludeFile( const std::string& sline,
                             const VecStr_t& strvect );
@@ -110,6 +137,28 @@ public:
     int verbosity{0};
     bool printonly{false};
     bool saveimages{false};
+    std::string comparefile;
+    bool comparenormdiff{false};
+    std::string goldentreefile;
+    bool makegoldentrees{false};
+    int soakupdates{0};
+    std::string memoryreport;
+    std::string profilefile;
+    bool iostats{false};
+    std::string iostatsfile;
+    std::string jsondir;
+    std::string snapshotfile;
+    std::string outputmanifest;
+    std::string trendfile;
+    std::vector<double> trendquantiles;
+    std::string mapfile;
+    std::string alarmlog;
+    int updateinterval{0};
+    long long displaymaxbins{-1};  // -1: default
+    long long scattermaxpoints{-1};
+    long long drawbuffer{-1};
+    std::vector<int> runs;      // More than one: multi-run batch job
+    bool daemon{false};
   };
 
   OnlineConfig();
@@ -117,6 +166,9 @@ public:
   explicit OnlineConfig( const CmdLineOpts& opts );
   bool ParseConfig();
   int GetRunNumber() const { return fRunNumber; }
+  const std::vector<int>& GetRuns() const { return fRuns; }
+  bool IsMultiRun() const { return fRuns.size() > 1; }
+  bool IsDaemon() const { return fDaemon; }
   std::string SubstituteRunNumber( std::string str, int runnumber ) const;
 
   const std::string& GetConfFilePath() const { return fConfFilePath; }
@@ -129,6 +181,9 @@ public:
   }
   void SetVerbosity( int ver ) { fVerbosity = ver; }
   const char* GetRootFile() const { return rootfilename.c_str(); };
+  const VecStr_t& GetRootSegments() const { return fRootSegments; }
+  bool IsMultiSegment() const { return fRootSegments.size() > 1; }
+  void FindSegments();
   const char* GetGoldenFile() const { return goldenrootfilename.c_str(); };
   const std::string& GetGuiColor() const { return guicolor; };
   const std::string& GetProtoPlotFile() const { return fProtoPlotFile; }
@@ -145,6 +200,28 @@ public:
   int GetPadNoWidth() const { return fPadNoWidth; }
   bool DoPrintOnly() const { return fPrintOnly; }
   bool DoSaveImages() const { return fSaveImages; }
+  bool DoCompare() const { return !fCompareFile.empty(); }
+  bool DoCompareNormDiff() const { return fCompareNormDiff; }
+  const std::string& GetCompareFile() const { return fCompareFile; }
+  const std::string& GetGoldenTreeFile() const { return fGoldenTreeFile; }
+  bool DoMakeGoldenTrees() const { return fMakeGoldenTrees; }
+  int GetSoakUpdates() const { return fSoakUpdates; }
+  const std::string& GetMemoryReportFile() const { return fMemoryReportFile; }
+  const std::string& GetProfileFile() const { return fProfileFile; }
+  bool DoIOStats() const { return fIOStats; }
+  const std::string& GetIOStatsFile() const { return fIOStatsFile; }
+  const std::string& GetJsonDir() const { return fJsonDir; }
+  const std::string& GetSnapshotFile() const { return fSnapshotFile; }
+  const std::string& GetOutputManifest() const { return fOutputManifest; }
+  const std::string& GetTrendFile() const { return fTrendFile; }
+  const std::vector<double>& GetTrendQuantiles() const { return fTrendQuantiles; }
+  const std::string& GetMapFile() const { return fMapFile; }
+  const std::string& GetAlarmLog() const { return fAlarmLog; }
+  int GetUpdateInterval() const { return fUpdateInterval; }
+  long long GetDisplayMaxBins() const { return fDisplayMaxBins; }
+  long long GetScatterMaxPoints() const { return fScatterMaxPoints; }
+  long long GetDrawBuffer() const { return fDrawBuffer; }
+  std::string GetConfigDigest() const;
   const std::string& GetDefinedCut( const std::string& ident );
   VecStr_t GetCutIdent();
   // Page utilites
@@ -154,7 +231,9 @@ public:
   std::string GetPageTitle( uint_t );
   uint_t GetDrawCount( uint_t );           // Number of histograms in a page
   void GetDrawCommand( uint_t, uint_t, std::map<std::string, std::string>& );
-  void OverrideRootFile( int runnumber );
+  bool OverrideRootFile( int runnumber );
+  bool SetRunFile( int runnumber, const std::string& filename );
+  void FindRunFiles( std::map<int, std::string>& files ) const;
   bool IsMonitor() const { return fMonitor; };
 };
 
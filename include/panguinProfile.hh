@@ -0,0 +1,107 @@
+#ifndef panguinProfile_h
+#define panguinProfile_h
+
+///////////////////////////////////////////////////////////////////
+//  Profiler
+//
+//  Records timed spans of the processing stages (file open,
+//  metadata scans, pad fills, canvas paint, image output) with
+//  page and pad labels. The result is written as Chrome trace-event
+//  JSON, viewable in chrome://tracing or ui.perfetto.dev, and a
+//  summary table is printed. When disabled, a Span costs one branch.
+//
+//  StartupTimer
+//
+//  Wall-clock breakdown of the startup, from main() to the first
+//  drawn page (--startup-timing). Startup spans main() and the
+//  construction of OnlineGUI, so there is one instance per process.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <iosfwd>
+
+class Profiler {
+public:
+  // Times the enclosing scope. 'name' must be a string literal. 'detail'
+  // must remain valid for the lifetime of the span.
+  class Span {
+  public:
+    Span( Profiler& prof, const char* name, int page = -1, int pad = -1,
+          const char* detail = nullptr )
+      : fProf{prof.IsEnabled() ? &prof : nullptr}
+      , fName{name}, fDetail{detail}, fPage{page}, fPad{pad}
+      , fStart{fProf ? fProf->Now() : 0} {}
+    Span( const Span& ) = delete;
+    Span& operator=( const Span& ) = delete;
+    ~Span()
+    {
+      if( fProf )
+        fProf->Record(fName, fPage, fPad, fDetail, fStart, fProf->Now() - fStart);
+    }
+  private:
+    Profiler* fProf;
+    const char* fName;
+    const char* fDetail;
+    int fPage, fPad;
+    double fStart;
+  };
+
+  Profiler() = default;
+  Profiler( const Profiler& ) = delete;
+  Profiler& operator=( const Profiler& ) = delete;
+
+  void Enable( const std::string& tracefile );
+  bool IsEnabled() const { return fEnabled; }
+  // Microseconds since Enable()
+  double Now() const;
+  void Record( const char* name, int page, int pad, const char* detail,
+               double start, double duration );
+  // Write the trace file and print the summary. Only the first call
+  // after Enable() has an effect.
+  int  Finish();
+  void PrintSummary( std::ostream& os ) const;
+  int  WriteTrace( const std::string& filename ) const;
+
+private:
+  struct Event {
+    const char* name;
+    std::string detail;
+    int page, pad;
+    int tid;
+    double start, duration;
+  };
+  bool fEnabled{false};
+  std::string fTraceFile;
+  std::chrono::steady_clock::time_point fT0;
+  std::vector<Event> fEvents;
+  std::map<std::thread::id, int> fThreads;
+  mutable std::mutex fMutex;
+};
+
+class StartupTimer {
+public:
+  static StartupTimer& Instance();
+
+  void Enable();
+  bool IsEnabled() const { return fEnabled; }
+  // Attribute the time since the previous mark to 'stage'. Ignored once
+  // the report has been printed.
+  void Mark( const char* stage );
+  // Print the breakdown. Only the first call has an effect.
+  void Report( std::ostream& os );
+
+private:
+  StartupTimer() = default;
+  bool fEnabled{false};
+  bool fReported{false};
+  double fCpuBefore{0};  // CPU time used before Enable() (s)
+  std::chrono::steady_clock::time_point fT0, fLast;
+  std::vector<std::pair<std::string, double>> fStages;
+};
+
+#endif //panguinProfile_h
@@ -0,0 +1,59 @@
+#ifndef panguinSnapshot_h
+#define panguinSnapshot_h
+
+///////////////////////////////////////////////////////////////////
+//  HistSnapshot
+//
+//  Persistent store of tree-draw results. Histograms are kept in a
+//  ROOT file, keyed by pad identity, together with a key describing
+//  the configuration and the identity of the input files. When the
+//  stored key matches, the histograms are used instead of drawing
+//  from the trees again. Histograms computed while the snapshot
+//  does not (yet) hold them are collected and, if writing is
+//  enabled, saved by Close(). The file is replaced atomically.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <map>
+#include <memory>
+
+class TFile;
+class TH1;
+
+class HistSnapshot {
+public:
+  HistSnapshot();
+  ~HistSnapshot();
+  HistSnapshot( const HistSnapshot& ) = delete;
+  HistSnapshot& operator=( const HistSnapshot& ) = delete;
+
+  // Use the snapshot file 'filename' for inputs described by 'key'.
+  // Stored histograms are only used if the file was made with the same key.
+  // With 'write', Close() saves the histograms added by Put().
+  void Open( const std::string& filename, const std::string& key,
+             bool write, int verbosity = 0 );
+  bool IsEnabled() const { return !fFileName.empty(); }
+  bool IsValid() const { return fFile != nullptr; }
+
+  // Copy of the stored histogram for pad 'padid', owned by the caller,
+  // or nullptr if not available.
+  TH1* Get( const std::string& padid );
+  // Record the result of drawing pad 'padid' (a copy is kept)
+  void Put( const std::string& padid, const TH1* hist );
+  // Report use, write the file if anything was added, and release it.
+  // Returns 1 on write error.
+  int  Close();
+
+  static const char* const kKeyName;
+
+private:
+  std::string fFileName;
+  std::string fKey;
+  bool fWrite{false};
+  int fVerbosity{0};
+  std::unique_ptr<TFile> fFile;  // Existing snapshot with matching key
+  std::map<std::string, std::unique_ptr<TH1>> fNew;
+  int fNhit{0};
+};
+
+#endif //panguinSnapshot_h
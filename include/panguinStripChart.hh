@@ -0,0 +1,43 @@
+#ifndef panguinStripChart_h
+#define panguinStripChart_h
+
+///////////////////////////////////////////////////////////////////
+//  StripChart
+//
+//  Time series of a per-update metric of a stripchart pad in
+//  watchfile mode, e.g. the entry rate of a tree or the mean of a
+//  variable over the entries added since the previous update. The
+//  last N points are kept in a fixed-size ring buffer. The number
+//  of tree entries already processed is kept as well, so that each
+//  update only looks at the new entries.
+///////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <cstddef>
+
+class TGraph;
+
+class StripChart {
+public:
+  explicit StripChart( std::size_t capacity = 100 );
+
+  void Push( double time, double value );
+  void Clear();
+  std::size_t Size() const { return fSize; }
+  std::size_t Capacity() const { return fTime.size(); }
+
+  // Graph of the buffered points, oldest first. The caller owns it.
+  TGraph* MakeGraph() const;
+
+  // Tree entries processed and time of the previous update
+  long long fLastEntries{-1};
+  double fLastTime{0};
+
+private:
+  std::vector<double> fTime;
+  std::vector<double> fValue;
+  std::size_t fNext{0};   // Index of the next point to write
+  std::size_t fSize{0};
+};
+
+#endif //panguinStripChart_h
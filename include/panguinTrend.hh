@@ -0,0 +1,78 @@
+#ifndef panguinTrend_h
+#define panguinTrend_h
+
+///////////////////////////////////////////////////////////////////
+//  TrendStore
+//
+//  Summary metrics of the histogram of each pad, per run, kept in
+//  an append-only ROOT tree ("trend") in a local file: entries,
+//  mean, RMS, integral, underflow, overflow and a chosen set of
+//  quantiles, keyed by run number and pad identity. Batch jobs
+//  append one entry per pad and run. Trend pads plot a metric
+//  against run number from the store; the store is read once and
+//  again only when the file changes. If a run was processed more
+//  than once, its most recent entry is used.
+///////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <map>
+
+class TH1;
+class TGraph;
+
+struct TrendPoint {
+  int run{0};
+  int page{0};
+  int pad{0};
+  std::string padid;          // Pad identity (hash of its definition)
+  std::string name;           // Variable or histogram drawn
+  double entries{0};
+  double mean{0};             // Along x
+  double rms{0};              // Along x
+  double integral{0};         // Excluding under- and overflow
+  double underflow{0};        // 1D histograms only
+  double overflow{0};
+  std::vector<double> qprob;  // Quantile probabilities (1D only)
+  std::vector<double> q;      // Quantiles
+};
+
+class TrendStore {
+public:
+  TrendStore();
+  TrendStore( const TrendStore& ) = delete;
+  TrendStore& operator=( const TrendStore& ) = delete;
+
+  void SetFile( const std::string& filename );
+  bool IsEnabled() const { return !fFileName.empty(); }
+  // Quantile probabilities to record, in (0,1)
+  void SetQuantiles( const std::vector<double>& qprob ) { fQProb = qprob; }
+
+  // Record the metrics of 'hist', drawn in the given pad, for 'run'
+  void Add( int run, int page, int pad, const std::string& padid,
+            const std::string& name, const TH1* hist );
+  // Append the recorded entries to the store. Returns 1 on error.
+  int  Flush();
+
+  // Graph of 'metric' against run number for the pad with the given name
+  // or identity. Metrics: entries, mean, rms, integral, underflow,
+  // overflow, and qNN for the quantile at NN percent (e.g. q50).
+  // Returns nullptr if there are no data. The caller owns the graph.
+  TGraph* MakeGraph( const std::string& pad, const std::string& metric );
+
+  static bool GetMetric( const TrendPoint& p, const std::string& metric,
+                         double& value );
+
+private:
+  std::string fFileName;
+  std::vector<double> fQProb;
+  std::vector<TrendPoint> fPending;
+  // Contents of the store by pad identity, then run
+  std::map<std::string, std::map<int, TrendPoint>> fPoints;
+  long fLoadedMtime{-1};
+  long long fLoadedSize{-1};
+
+  int Load();
+};
+
+#endif //panguinTrend_h
@@ -5,8 +5,12 @@
 #include <TROOT.h>
 #include <TSystem.h>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 #define PANGUIN_VERSION "Panguin version 2.5 (23-Oct-2022)"
 
@@ -14,15 +18,88 @@ using namespace std;
 
 unique_ptr<OnlineGUI> online( const OnlineConfig::CmdLineOpts& opts );
 
+// Most runs one batch job may process
+static const size_t kMaxRuns = 100000;
+
+//_____________________________________________________________________________
+// Append the runs given by 'spec' to 'runs'. 'spec' is a comma-separated
+// list of run numbers and inclusive ranges, e.g. "1200-1350,1400". Run 0
+// (use the configuration's rootfile) is accepted as a single run only.
+static void ParseRuns( const string& spec, vector<int>& runs )
+{
+  istringstream istr(spec);
+  string item;
+  while( getline(istr, item, ',') ) {
+    if( item.empty() )
+      continue;
+    try {
+      size_t pos = 0;
+      int first = stoi(item, &pos), last = first;
+      if( pos < item.size() && item[pos] == '-' ) {
+        string rest = item.substr(pos + 1);
+        last = stoi(rest, &pos);
+        pos += item.size() - rest.size();
+      }
+      if( pos != item.size() || first < 0 || last < first ||
+          (first == 0 && (last > 0 || spec != "0")) )
+        throw invalid_argument(item);
+      if( size_t(last - first) >= kMaxRuns - runs.size() )
+        throw runtime_error("Too many runs, at most " + to_string(kMaxRuns) +
+                            " are supported: \"" + item + "\"");
+      for( int run = first; run <= last; ++run )
+        runs.push_back(run);
+    }
+    catch( const logic_error& ) {
+      throw runtime_error("Invalid run number or range: \"" + item + "\"");
+    }
+  }
+}
+
+//_____________________________________________________________________________
+// Read runs from 'filename': run numbers or ranges, separated by whitespace,
+// commas or newlines. Text after '#' is ignored.
+static void ReadRunsFile( const string& filename, vector<int>& runs )
+{
+  ifstream ifs(filename);
+  if( !ifs )
+    throw runtime_error("Cannot open runs file " + filename);
+  string line;
+  while( getline(ifs, line) ) {
+    line.erase(min(line.find('#'), line.size()));
+    istringstream istr(line);
+    string spec;
+    while( istr >> spec )
+      ParseRuns(spec, runs);
+  }
+}
+
 int main( int argc, char** argv )
 {
   string cfgfile{"default.cfg"}, rootfile, goldenfile;
-  string plotfmt, imgfmt;
+  string plotfmt, imgfmt, comparefile, goldentreefile, memoryreport;
+  string profilefile, iostatsfile, jsondir, snapshotfile, outputmanifest;
+  string trendfile, mapfile, alarmlog;
+  vector<double> trendquantiles;
   string cfgdir, rootdir, pltdir, imgdir;
-  int run{0};
+  string runspec, runsfile;
+  string daemonstate{"panguin_daemon.state"};
+  vector<int> runs;
+  int pollInterval{10};
+  int settleTime{30};
+  int firstRun{0};
+  int updateInterval{0};
+  long long displayMaxBins{-1};
+  long long scatterMaxPoints{-1};
+  long long drawBuffer{-1};
   int verbosity{0};
+  int soakUpdates{0};
   bool printonly{false};
   bool saveImages{false};
+  bool compareNormDiff{false};
+  bool makeGoldenTrees{false};
+  bool ioStats{false};
+  bool daemon{false};
+  bool startupTiming{false};
 
   try {
     CLI::App cli("panguin: configurable ROOT data visualization tool");
@@ -30,9 +107,13 @@ int main( int argc, char** argv )
     cli.add_option("-f,--config-file", cfgfile,
                    "Job configuration file")
       ->capture_default_str()->type_name("<file name>");
-    cli.add_option("-r,--run", run,
-                   "Run number")
+    cli.add_option("-r,--run", runspec,
+                   "Run number, or runs and ranges like 1200-1350,1400 "
+                   "to print in one batch job (implies -P)")
       ->type_name("<run number>");
+    cli.add_option("--runs-file", runsfile,
+                   "File with runs to print in one batch job (implies -P)")
+      ->type_name("<file name>");
     cli.add_option("-R,--root-file", rootfile,
                    "ROOT file to process")
       ->type_name("<file name>");
@@ -62,6 +143,106 @@ int main( int argc, char** argv )
     cli.add_option("-H,--images-dir", imgdir,
                    "Output directory for individual images (default: plots-dir)")
       ->type_name("<dir>");
+    cli.add_option("--compare", comparefile,
+                   "Compare all histograms with the golden file and write "
+                   "report (.json or .csv) and summary page (implies -P)")
+      ->type_name("<file name>");
+    cli.add_flag("--compare-normdiff", compareNormDiff,
+                 "Include normalized difference in comparison report");
+    cli.add_option("--golden-trees", goldentreefile,
+                   "Reference file with golden tree-draw results "
+                   "(default: <golden file>_goldentrees.root)")
+      ->type_name("<file name>");
+    cli.add_flag("--make-golden-trees", makeGoldenTrees,
+                 "Run configuration against the golden ROOT file and save "
+                 "tree-draw results as references (implies -P)");
+    cli.add_option("--soak", soakUpdates,
+                   "Redraw all pages N times without output and report "
+                   "memory use (implies -P)")
+      ->type_name("<N>");
+    cli.add_option("--memory-report", memoryreport,
+                   "Write memory use per page and pad to JSON file")
+      ->type_name("<file name>");
+    cli.add_option("--profile", profilefile,
+                   "Write timing of processing stages as Chrome trace-event "
+                   "JSON and print a summary at exit")
+      ->type_name("<file name>");
+    cli.add_flag("--io-stats", ioStats,
+                 "Report tree I/O per branch, pad and page");
+    cli.add_option("--io-stats-file", iostatsfile,
+                   "Save TTreePerfStats of each tree-variable pad to ROOT "
+                   "file (implies --io-stats)")
+      ->type_name("<file name>");
+    cli.add_flag("--daemon", daemon,
+                 "Watch for the ROOT files of new runs and print plots for "
+                 "each one when it is complete (implies -P)");
+    cli.add_option("--daemon-state", daemonstate,
+                   "File recording the runs done by the daemon")
+      ->capture_default_str()->type_name("<file name>");
+    cli.add_option("--poll-interval", pollInterval,
+                   "Seconds between scans for new files (daemon)")
+      ->capture_default_str()->type_name("<s>");
+    cli.add_option("--settle-time", settleTime,
+                   "Seconds a file must be unchanged before it is processed "
+                   "(daemon)")
+      ->capture_default_str()->type_name("<s>");
+    cli.add_option("--first-run", firstRun,
+                   "Ignore runs below this number (daemon)")
+      ->type_name("<run number>");
+    cli.add_flag("--startup-timing", startupTiming,
+                 "Print the time taken by each startup stage up to the "
+                 "first drawn page");
+    cli.add_option("--json-dir", jsondir,
+                   "Write each pad as ROOT JSON, with a manifest, to this "
+                   "directory. Only changed pads are rewritten")
+      ->type_name("<dir>");
+    cli.add_option("--snapshot", snapshotfile,
+                   "Keep tree-draw results in this ROOT file and reuse them "
+                   "while configuration and input are unchanged. Written "
+                   "in batch mode only")
+      ->type_name("<file>");
+    cli.add_option("--output-manifest", outputmanifest,
+                   "Keep content digests of the images and plot pages "
+                   "written in this file, and skip outputs that did not "
+                   "change")
+      ->type_name("<file>");
+    cli.add_option("--trend-file", trendfile,
+                   "Append summary metrics of each pad to this ROOT file in "
+                   "batch mode, and read trend pads from it")
+      ->type_name("<file>");
+    cli.add_option("--trend-quantiles", trendquantiles,
+                   "Quantiles to record in the trend file "
+                   "(default: 0.1,0.5,0.9)")
+      ->delimiter(',')->check(CLI::Range(0.0, 1.0))
+      ->type_name("<p1,p2,...>");
+    cli.add_option("--map-file", mapfile,
+                   "Read histograms from this shared-memory map file "
+                   "(TMapFile) of a running producer instead of a ROOT "
+                   "file. Implies watchfile")
+      ->type_name("<file>");
+    cli.add_option("--alarm-log", alarmlog,
+                   "Append the alarms raised and cleared by the -check "
+                   "pad options to this file "
+                   "(default: panguin_alarms.log)")
+      ->type_name("<file>");
+    cli.add_option("--update-interval", updateInterval,
+                   "Watchfile update interval in ms "
+                   "(default: 10000, 500 with --map-file)")
+      ->check(CLI::PositiveNumber)->type_name("<ms>");
+    cli.add_option("--display-max-bins", displayMaxBins,
+                   "Draw histograms with more bins than this through a copy "
+                   "rebinned to the pad's pixel size (default: 100000, "
+                   "0: never)")
+      ->check(CLI::NonNegativeNumber)->type_name("<N>");
+    cli.add_option("--scatter-max-points", scatterMaxPoints,
+                   "Draw scatter plots of more entries than this as a "
+                   "density map (default: 1000000, 0: never)")
+      ->check(CLI::NonNegativeNumber)->type_name("<N>");
+    cli.add_option("--draw-buffer", drawBuffer,
+                   "Maximum number of entries buffered by multi-dimensional "
+                   "tree draws; larger draws find their axis ranges in a "
+                   "separate pass (default: 1000000, 0: no limit)")
+      ->check(CLI::NonNegativeNumber)->type_name("<N>");
     cli.add_option("-v,--verbosity", verbosity,
                    "Set verbosity level (>=0)")
       ->type_name("<level>");
@@ -69,12 +250,44 @@ int main( int argc, char** argv )
 
     CLI11_PARSE(cli, argc, argv)
 
+    if( !comparefile.empty() || makeGoldenTrees || soakUpdates > 0 )
+      printonly = true;
+
+    ParseRuns(runspec, runs);
+    if( !runsfile.empty() )
+      ReadRunsFile(runsfile, runs);
+    if( runs.size() == 1 && runs.front() == 0 )
+      runs.clear();  // -r 0: the rootfile of the configuration
+    else if( find(runs.begin(), runs.end(), 0) != runs.end() )
+      throw runtime_error("Run 0 cannot be combined with other runs");
+    if( runs.size() > 1 ) {
+      if( !rootfile.empty() )
+        throw runtime_error("Multiple runs cannot be combined with -R");
+      if( !comparefile.empty() || makeGoldenTrees || soakUpdates > 0 )
+        throw runtime_error("Multiple runs are supported only for printing "
+                            "plots and images");
+      printonly = true;
+    }
+    if( daemon ) {
+      if( !runs.empty() || !rootfile.empty() )
+        throw runtime_error("--daemon cannot be combined with -r or -R");
+      if( !comparefile.empty() || makeGoldenTrees || soakUpdates > 0 )
+        throw runtime_error("--daemon is supported only for printing plots "
+                            "and images");
+      if( pollInterval < 1 || settleTime < 0 )
+        throw runtime_error("Invalid --poll-interval or --settle-time");
+      printonly = true;
+    }
+
     if( saveImages ) {
       printonly = true;
       if( imgdir.empty() )
         imgdir = pltdir;
     }
 
+    if( startupTiming )
+      StartupTimer::Instance().Enable();
+
     if( verbosity <= 0 ) {
       verbosity = 0;
     } else if( verbosity > 0 ) {
@@ -88,18 +301,55 @@ int main( int argc, char** argv )
     if( !gSystem->AccessPathName("~/rootlogon.C") ) {
       gROOT->ProcessLine(".x ~/rootlogon.C");
     }
+    StartupTimer::Instance().Mark("rootlogon");
 
     TApplication theApp("panguin2", &argc, argv, nullptr, -1);
-    auto gui
-      = online({cfgfile, cfgdir, rootfile, goldenfile, rootdir, plotfmt,
-                imgfmt, pltdir, imgdir, run, verbosity, printonly,
-                saveImages});
+    StartupTimer::Instance().Mark("TApplication");
+    OnlineConfig::CmdLineOpts opts{cfgfile, cfgdir, rootfile, goldenfile,
+                                   rootdir, plotfmt, imgfmt, pltdir, imgdir,
+                                   runs.empty() ? 0 : runs.front(),
+                                   verbosity, printonly, saveImages};
+    opts.comparefile = comparefile;
+    opts.comparenormdiff = compareNormDiff;
+    opts.goldentreefile = goldentreefile;
+    opts.makegoldentrees = makeGoldenTrees;
+    opts.soakupdates = soakUpdates;
+    opts.memoryreport = memoryreport;
+    opts.profilefile = profilefile;
+    opts.iostats = ioStats;
+    opts.iostatsfile = iostatsfile;
+    opts.jsondir = jsondir;
+    opts.snapshotfile = snapshotfile;
+    opts.outputmanifest = outputmanifest;
+    opts.trendfile = trendfile;
+    opts.trendquantiles = trendquantiles;
+    opts.mapfile = mapfile;
+    opts.alarmlog = alarmlog;
+    opts.updateinterval = updateInterval;
+    opts.displaymaxbins = displayMaxBins;
+    opts.scattermaxpoints = scatterMaxPoints;
+    opts.drawbuffer = drawBuffer;
+    if( runs.size() > 1 )
+      opts.runs = runs;
+    opts.daemon = daemon;
+    auto gui = online(opts);
     if( gui ) {
-      if( gui->IsPrintOnly() )
+      if( opts.runs.size() > 1 )
+        return gui->PrintRuns() == 0 ? 0 : 1;
+      if( daemon )
+        return gui->RunDaemon(daemonstate, pollInterval, settleTime, firstRun);
+      if( gui->IsMakeGoldenTrees() )
+        gui->BuildGoldenTreeCache();
+      else if( gui->IsSoakTest() )
+        gui->SoakTest(soakUpdates);
+      else if( gui->IsCompare() )
+        gui->CompareGolden();
+      else if( gui->IsPrintOnly() )
         gui->PrintPages();
       else
         theApp.Run(true);
-    }
+    } else
+      return 1;
 
   } catch ( const exception& e ) {
     cerr << "Error while running panguin: " << e.what() << endl;
@@ -129,6 +379,7 @@ unique_ptr<OnlineGUI> online( const OnlineConfig::CmdLineOpts& opts )
   if( !guipath.IsNull() )
     macropath = ".:" + guipath + ":" + macropath;
   gROOT->SetMacroPath(macropath);
+  StartupTimer::Instance().Mark("configuration");
 
 #if __cplusplus >= 201402L
   return make_unique<OnlineGUI>(std::move(fconfig));
@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////
+//  Alarms: pad checks evaluated on every watchfile update
+///////////////////////////////////////////////////////////////////
+
+#include "panguinAlarm.hh"
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Parse the number 'str' into 'value', unless 'str' is empty
+static bool ParseBound( const string& str, double& value )
+{
+  if( str.empty() )
+    return true;
+  try {
+    size_t pos = 0;
+    value = stod(str, &pos);
+    return pos == str.size();
+  }
+  catch( const std::exception& ) {
+    return false;
+  }
+}
+
+//_____________________________________________________________________________
+bool AlarmCheck::Parse( const string& list, vector<AlarmCheck>& checks,
+                        string& error )
+{
+  checks.clear();
+  istringstream istr(list);
+  string spec;
+  while( getline(istr, spec, ',') ) {
+    if( spec.empty() )
+      continue;
+    AlarmCheck check;
+    check.fSpec = spec;
+    check.fMin = -numeric_limits<double>::infinity();
+    check.fMax = numeric_limits<double>::infinity();
+    auto eq = spec.find('=');
+    string name = spec.substr(0, eq);
+    string args = eq == string::npos ? string() : spec.substr(eq + 1);
+    if( name == "empty" ) {
+      check.fType = kEmpty;
+      if( eq != string::npos ) {
+        error = "check \"" + spec + "\" takes no value";
+        return false;
+      }
+    } else if( name == "ks" ) {
+      check.fType = kKS;
+      if( args.empty() || !ParseBound(args, check.fMin) ||
+          check.fMin < 0 || check.fMin > 1 ) {
+        error = "check \"" + spec + "\" needs a probability, e.g. ks=0.01";
+        return false;
+      }
+    } else if( name == "mean" || name == "rms" || name == "rate" ) {
+      check.fType = name == "mean" ? kMean : name == "rms" ? kRMS : kRate;
+      auto colon = args.find(':');
+      if( colon == string::npos || args.size() == 1 ||
+          !ParseBound(args.substr(0, colon), check.fMin) ||
+          !ParseBound(args.substr(colon + 1), check.fMax) ) {
+        error = "check \"" + spec + "\" needs a range <min>:<max>, "
+                "e.g. " + name + "=0:10 or " + name + "=:10";
+        return false;
+      }
+    } else {
+      error = "unknown check \"" + spec + "\"";
+      return false;
+    }
+    checks.push_back(check);
+  }
+  return true;
+}
+
+//_____________________________________________________________________________
+string AlarmCheck::Test( const AlarmValues& v ) const
+{
+  ostringstream ostr;
+  auto range = [&]( const char* name, double value ) {
+    if( value >= fMin && value <= fMax )
+      return;
+    ostr << name << " = " << value << " outside [";
+    if( fMin > -numeric_limits<double>::infinity() )
+      ostr << fMin;
+    ostr << ":";
+    if( fMax < numeric_limits<double>::infinity() )
+      ostr << fMax;
+    ostr << "]";
+  };
+  switch( fType ) {
+    case kEmpty:
+      if( v.entries <= 0 )
+        ostr << "empty";
+      break;
+    case kMean:
+      if( v.entries > 0 )
+        range("mean", v.mean);
+      break;
+    case kRMS:
+      if( v.entries > 0 )
+        range("rms", v.rms);
+      break;
+    case kKS:
+      if( v.ks >= 0 && v.ks < fMin )
+        ostr << "KS probability = " << v.ks << " < " << fMin;
+      break;
+    case kRate:
+      if( v.rate >= 0 )
+        range("rate", v.rate);
+      break;
+  }
+  return ostr.str();
+}
+
+//_____________________________________________________________________________
+// Updates without a change of the input after which it is taken as stalled
+static const double kStallUpdates = 3;
+
+//_____________________________________________________________________________
+void PadAlarm::SetEntries( double entries, double now, double interval )
+{
+  values.entries = entries;
+  if( lastEntries < 0 || entries < lastEntries ) {
+    // First look, or a new run: only set the starting point
+    lastEntries = evalEntries = entries;
+    lastTime = evalTime = now;
+    prevEntries = -1;
+    values.rate = -1;
+    return;
+  }
+  if( entries > lastEntries ) {
+    prevEntries = lastEntries;
+    prevTime = lastTime;
+    lastEntries = entries;
+    lastTime = now;
+  }
+  // The input may be written less often than it is evaluated. It has
+  // stalled only if it did not change for clearly longer than it takes
+  // between updates and between its own writes.
+  double quiet = kStallUpdates * interval;
+  if( prevEntries >= 0 )
+    quiet = max(quiet, 2 * (lastTime - prevTime));
+  if( now - lastTime > quiet && now > evalTime ) {
+    // Stalled: the rate over the latest interval, i.e. zero
+    values.rate = (entries - evalEntries) / (now - evalTime);
+  } else if( prevEntries >= 0 && lastTime > prevTime ) {
+    // Between the last two changes of the input, so that it stays the same
+    // between writes
+    values.rate = (lastEntries - prevEntries) / (lastTime - prevTime);
+  }
+  evalEntries = entries;
+  evalTime = now;
+}
+
+//_____________________________________________________________________________
+void PadAlarm::Reset()
+{
+  values = AlarmValues();
+  source.clear();
+  treeEntries = -1;
+  selected = 0;
+  sumw = sumwx = sumwx2 = 0;
+  lastEntries = prevEntries = evalEntries = -1;
+}
+
+//_____________________________________________________________________________
+void AlarmLog::Write( const string& line )
+{
+  if( fFileName.empty() )
+    return;
+  if( !fOut.is_open() ) {
+    fOut.open(fFileName, ios::app);
+    if( !fOut ) {
+      cerr << "ERROR: Cannot open alarm log " << fFileName << endl;
+      fFileName.clear();
+      return;
+    }
+  }
+  fOut << line << endl;
+}
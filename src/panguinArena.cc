@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////
+//  PadArena: ownership of objects created while drawing pads
+///////////////////////////////////////////////////////////////////
+
+#include "panguinArena.hh"
+#include <TObject.h>
+#include <TH1.h>
+#include <limits>
+
+using namespace std;
+
+//_____________________________________________________________________________
+PadArena::~PadArena()
+{
+  ReleaseAll();
+}
+
+//_____________________________________________________________________________
+void PadArena::AdoptObject( int page, int pad, TObject* obj )
+{
+  if( !obj )
+    return;
+  auto& objs = fObjects[make_pair(page, pad)];
+  for( const auto& o: objs ) {
+    if( o.get() == obj )
+      return;
+  }
+  // We own it now: neither the pad nor a directory may delete it
+  obj->ResetBit(TObject::kCanDelete);
+  if( auto* hist = dynamic_cast<TH1*>(obj) )
+    hist->SetDirectory(nullptr);
+  objs.emplace_back(obj);
+}
+
+//_____________________________________________________________________________
+void PadArena::Release( int page, int pad )
+{
+  fObjects.erase(make_pair(page, pad));
+}
+
+//_____________________________________________________________________________
+void PadArena::ReleasePage( int page )
+{
+  auto it = fObjects.lower_bound(make_pair(page, numeric_limits<int>::min()));
+  while( it != fObjects.end() && it->first.first == page )
+    it = fObjects.erase(it);
+}
+
+//_____________________________________________________________________________
+void PadArena::ReleaseAll()
+{
+  fObjects.clear();
+}
+
+//_____________________________________________________________________________
+size_t PadArena::GetSize() const
+{
+  size_t n = 0;
+  for( const auto& entry: fObjects )
+    n += entry.second.size();
+  return n;
+}
+
+//_____________________________________________________________________________
+size_t PadArena::GetSize( int page, int pad ) const
+{
+  auto it = fObjects.find(make_pair(page, pad));
+  return it != fObjects.end() ? it->second.size() : 0;
+}
+
+//_____________________________________________________________________________
+const vector<unique_ptr<TObject>>* PadArena::Get( int page, int pad ) const
+{
+  auto it = fObjects.find(make_pair(page, pad));
+  return it != fObjects.end() ? &it->second : nullptr;
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////
+//  CanvasPool: reusable off-screen canvases
+///////////////////////////////////////////////////////////////////
+
+#include "panguinCanvasPool.hh"
+#include <TCanvas.h>
+#include <TString.h>
+
+using namespace std;
+
+//_____________________________________________________________________________
+CanvasPool::Lease::Lease( Lease&& rhs ) noexcept
+  : fPool(rhs.fPool), fCanvas(rhs.fCanvas)
+  , fWidth(rhs.fWidth), fHeight(rhs.fHeight)
+{
+  rhs.fPool = nullptr;
+  rhs.fCanvas = nullptr;
+}
+
+//_____________________________________________________________________________
+CanvasPool::Lease& CanvasPool::Lease::operator=( Lease&& rhs ) noexcept
+{
+  if( this != &rhs ) {
+    reset();
+    fPool = rhs.fPool;
+    fCanvas = rhs.fCanvas;
+    fWidth = rhs.fWidth;
+    fHeight = rhs.fHeight;
+    rhs.fPool = nullptr;
+    rhs.fCanvas = nullptr;
+  }
+  return *this;
+}
+
+//_____________________________________________________________________________
+void CanvasPool::Lease::reset()
+{
+  if( fPool && fCanvas )
+    fPool->Release(fCanvas, make_pair(fWidth, fHeight));
+  fPool = nullptr;
+  fCanvas = nullptr;
+}
+
+//_____________________________________________________________________________
+CanvasPool::~CanvasPool()
+{
+  for( auto& entry: fIdle ) {
+    for( auto* c: entry.second )
+      delete c;
+  }
+}
+
+//_____________________________________________________________________________
+CanvasPool::Lease CanvasPool::Acquire( unsigned int width, unsigned int height )
+{
+  key_t key = make_pair(width, height);
+  TCanvas* c = nullptr;
+  {
+    // Creation is serialized as well, since it registers the canvas
+    // with ROOT's global list of canvases
+    lock_guard<mutex> lock(fMutex);
+    auto& idle = fIdle[key];
+    if( !idle.empty() ) {
+      c = idle.back();
+      idle.pop_back();
+      ++fReused;
+    } else {
+      // Canvas names must be unique; a new canvas replaces any canvas
+      // of the same name
+      TString name = Form("panguin_canvas_%lu", fCreated++);
+      c = new TCanvas(name, name, width, height);
+      c->SetBatch();
+      c->SetCanvasSize(width, height);
+    }
+  }
+  c->cd();
+  return {this, c, width, height};
+}
+
+//_____________________________________________________________________________
+void CanvasPool::Release( TCanvas* canvas, const key_t& key )
+{
+  // Delete what was drawn, and reset the pad settings that drawing commonly
+  // changes, so that the next user starts from a blank canvas
+  canvas->Clear();
+  canvas->SetLogx(0);
+  canvas->SetLogy(0);
+  canvas->SetLogz(0);
+  canvas->SetGrid(0, 0);
+  lock_guard<mutex> lock(fMutex);
+  auto& idle = fIdle[key];
+  if( idle.size() < fMaxIdle )
+    idle.push_back(canvas);
+  else
+    delete canvas;
+}
@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////
+//  Statistical comparison of histograms with their golden
+//  (reference) counterparts.
+///////////////////////////////////////////////////////////////////
+
+#include "panguinCompare.hh"
+#include "panguinOnlineConfig.hh"  // JsonQuote, CsvQuote, EndsWith
+#include <TH1.h>
+#include <TROOT.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Agreement score used for sorting. The smaller of the available test
+// probabilities (and 1 - normalized difference, if computed).
+double CompareResult::Score() const
+{
+  double score = 1.0;
+  if( ks >= 0 )
+    score = min(score, ks);
+  if( chi2prob >= 0 )
+    score = min(score, chi2prob);
+  if( normdiff >= 0 )
+    score = min(score, 1.0 - normdiff);
+  return score;
+}
+
+//_____________________________________________________________________________
+GoldenCompare::GoldenCompare( bool do_normdiff, unsigned int nthreads )
+  : fDoNormDiff{do_normdiff}
+  , fNthreads{nthreads}
+{
+  if( fNthreads == 0 )
+    fNthreads = max(1U, thread::hardware_concurrency());
+}
+
+//_____________________________________________________________________________
+void GoldenCompare::Add( const string& name, const TH1* hist, const TH1* golden )
+{
+  fPairs.push_back({name, hist, golden});
+}
+
+//_____________________________________________________________________________
+// Sum of absolute differences of the unit-normalized bin contents, divided
+// by 2, so that identical shapes give 0 and disjoint ones give 1.
+static double NormalizedDifference( const TH1* h1, const TH1* h2 )
+{
+  double s1 = h1->GetSumOfWeights(), s2 = h2->GetSumOfWeights();
+  if( s1 <= 0 || s2 <= 0 )
+    return -1;
+  double diff = 0;
+  for( Int_t i = 0; i < h1->GetNcells(); ++i )
+    diff += fabs(h1->GetBinContent(i) / s1 - h2->GetBinContent(i) / s2);
+  return 0.5 * diff;
+}
+
+//_____________________________________________________________________________
+CompareResult GoldenCompare::Compare( const Pair& p ) const
+{
+  CompareResult res;
+  res.name = p.name;
+  if( !p.hist || !p.golden ) {
+    res.status = "missing";
+    return res;
+  }
+  res.type = p.hist->ClassName();
+  res.entries = p.hist->GetEntries();
+  res.golden_entries = p.golden->GetEntries();
+  if( p.hist->GetDimension() != p.golden->GetDimension() ||
+      p.hist->GetNcells() != p.golden->GetNcells() ) {
+    res.status = "incompatible binning";
+    return res;
+  }
+  if( res.entries == 0 || res.golden_entries == 0 ) {
+    res.status = "empty";
+    return res;
+  }
+  res.ks = p.hist->KolmogorovTest(p.golden);
+
+  string opt = p.hist->GetSumw2N() > 0 ? "W" : "U";
+  opt += p.golden->GetSumw2N() > 0 ? "W" : "U";
+  Int_t igood = 0;
+  res.chi2prob = p.hist->Chi2TestX(p.golden, res.chi2, res.ndf, igood,
+                                   opt.c_str());
+  if( fDoNormDiff )
+    res.normdiff = NormalizedDifference(p.hist, p.golden);
+  res.status = "ok";
+  return res;
+}
+
+//_____________________________________________________________________________
+// Run all queued comparisons on up to fNthreads worker threads. Results are
+// sorted by agreement, worst first. Pairs that could not be compared go last.
+void GoldenCompare::Run()
+{
+  fResults.clear();
+  fResults.resize(fPairs.size());
+  if( fPairs.empty() )
+    return;
+
+  unsigned int nthreads = min(fNthreads, static_cast<unsigned int>(fPairs.size()));
+  if( nthreads > 1 )
+    ROOT::EnableThreadSafety();
+
+  atomic<size_t> next{0};
+  auto worker = [&]() {
+    size_t i;
+    while( (i = next++) < fPairs.size() )
+      fResults[i] = Compare(fPairs[i]);
+  };
+  vector<thread> workers;
+  for( unsigned int i = 1; i < nthreads; ++i )
+    workers.emplace_back(worker);
+  worker();
+  for( auto& w: workers )
+    w.join();
+
+  stable_sort(fResults.begin(), fResults.end(),
+              []( const CompareResult& a, const CompareResult& b ) {
+                if( a.IsOk() != b.IsOk() )
+                  return a.IsOk();
+                return a.Score() < b.Score();
+              });
+}
+
+//_____________________________________________________________________________
+int GoldenCompare::WriteCSV( ostream& os ) const
+{
+  os << "name,type,entries,golden_entries,ks,chi2,ndf,chi2prob,normdiff,status"
+     << endl;
+  for( const auto& r: fResults ) {
+    os << CsvQuote(r.name) << "," << CsvQuote(r.type) << ","
+       << r.entries << "," << r.golden_entries << ","
+       << r.ks << "," << r.chi2 << "," << r.ndf << ","
+       << r.chi2prob << "," << r.normdiff << ","
+       << CsvQuote(r.status) << endl;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+int GoldenCompare::WriteJSON( ostream& os ) const
+{
+  os << "{" << endl << "  \"comparisons\": [";
+  const char* sep = "";
+  for( const auto& r: fResults ) {
+    os << sep << endl
+       << "    {\"name\": " << JsonQuote(r.name)
+       << ", \"type\": " << JsonQuote(r.type)
+       << ", \"entries\": " << r.entries
+       << ", \"golden_entries\": " << r.golden_entries
+       << ", \"ks\": " << r.ks
+       << ", \"chi2\": " << r.chi2
+       << ", \"ndf\": " << r.ndf
+       << ", \"chi2prob\": " << r.chi2prob;
+    if( fDoNormDiff )
+      os << ", \"normdiff\": " << r.normdiff;
+    os << ", \"status\": " << JsonQuote(r.status) << "}";
+    sep = ",";
+  }
+  os << endl << "  ]" << endl << "}" << endl;
+  return 0;
+}
+
+//_____________________________________________________________________________
+// Write the comparison report to 'filename'. The format is CSV if the file
+// name ends with ".csv", JSON otherwise.
+int GoldenCompare::WriteReport( const string& filename ) const
+{
+  ofstream ofs(filename);
+  if( !ofs ) {
+    cerr << "ERROR: Cannot open comparison report file " << filename << endl;
+    return 1;
+  }
+  ofs << setprecision(6);
+  if( EndsWith(filename, ".csv") )
+    return WriteCSV(ofs);
+  return WriteJSON(ofs);
+}
@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////
+//  DisplayCache: pixel-resolution copies of large histograms
+///////////////////////////////////////////////////////////////////
+
+#include "panguinDisplayCache.hh"
+#include <TH1.h>
+#include <TAxis.h>
+#include <TList.h>
+#include <TVirtualPad.h>
+#include <TMath.h>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Size of the plot area of 'pad' in pixels
+static void PlotPixels( TVirtualPad* pad, int& px, int& py )
+{
+  px = TMath::Nint(pad->GetWw() * pad->GetAbsWNDC() *
+                   (1. - pad->GetLeftMargin() - pad->GetRightMargin()));
+  py = TMath::Nint(pad->GetWh() * pad->GetAbsHNDC() *
+                   (1. - pad->GetTopMargin() - pad->GetBottomMargin()));
+  px = max(px, 1);
+  py = max(py, 1);
+}
+
+//_____________________________________________________________________________
+// Link of 'obj' in the list of primitives of 'pad'
+static TObjLink* FindLink( TVirtualPad* pad, const TObject* obj )
+{
+  TList* prims = pad->GetListOfPrimitives();
+  for( TObjLink* lnk = prims ? prims->FirstLink() : nullptr; lnk;
+       lnk = lnk->Next() ) {
+    if( lnk->GetObject() == obj )
+      return lnk;
+  }
+  return nullptr;
+}
+
+//_____________________________________________________________________________
+// Group the bins of 'axis' so that the bins first..last make about 'pixels'
+// display bins, and the bins on either side of them are grouped as for the
+// whole axis. Returns the display bin of each bin, including under- and
+// overflow, and fills the display bin edges.
+static vector<int> GroupBins( const TAxis* axis, int first, int last,
+                              int pixels, vector<double>& edges )
+{
+  int n = axis->GetNbins();
+  vector<int> map(n + 2, 0);
+  edges.clear();
+  int nd = 0;
+  auto group = [&]( int lo, int hi, int ngroup ) {
+    for( int i = lo; i <= hi; i += ngroup ) {
+      edges.push_back(axis->GetBinLowEdge(i));
+      ++nd;
+      for( int j = i; j <= min(i + ngroup - 1, hi); ++j )
+        map[j] = nd;
+    }
+  };
+  int nout = max(1, (n + pixels - 1) / pixels);
+  group(1, first - 1, nout);
+  group(first, last, max(1, (last - first + pixels) / pixels));
+  group(last + 1, n, nout);
+  edges.push_back(axis->GetBinUpEdge(n));
+  map[n + 1] = nd + 1;
+  return map;
+}
+
+//_____________________________________________________________________________
+// Bins of the full histogram in the visible range of display axis 'da'
+static void VisibleBins( const vector<int>& map, const TAxis* da,
+                         int& first, int& last )
+{
+  int n = static_cast<int>(map.size()) - 2;
+  first = 1;
+  last = n;
+  while( first < n && map[first] < da->GetFirst() )
+    ++first;
+  while( last > first && map[last] > da->GetLast() )
+    --last;
+}
+
+//_____________________________________________________________________________
+// First and last shown bins of the x and y axes of 'display'
+void DisplayCache::GetRange( const TH1* display, int range[4] )
+{
+  range[0] = display->GetXaxis()->GetFirst();
+  range[1] = display->GetXaxis()->GetLast();
+  range[2] = display->GetYaxis()->GetFirst();
+  range[3] = display->GetYaxis()->GetLast();
+}
+
+//_____________________________________________________________________________
+TH1* DisplayCache::MakeDisplay( const TH1* full, int xfirst, int xlast,
+                                int yfirst, int ylast, Entry& e )
+{
+  bool is2d = full->GetDimension() == 2;
+  vector<double> xedges, yedges;
+  e.xmap = GroupBins(full->GetXaxis(), xfirst, xlast, e.px, xedges);
+  if( is2d )
+    e.ymap = GroupBins(full->GetYaxis(), yfirst, ylast, e.py, yedges);
+  else
+    e.ymap.assign(1, 0);
+
+  auto* display = static_cast<TH1*>(full->Clone());
+  display->SetDirectory(nullptr);
+  int nx = static_cast<int>(xedges.size()) - 1;
+  if( is2d )
+    display->SetBins(nx, xedges.data(),
+                     static_cast<int>(yedges.size()) - 1, yedges.data());
+  else
+    display->SetBins(nx, xedges.data());
+  display->Reset("ICES");
+
+  const TArrayD* fsumw2 = full->GetSumw2();
+  bool errors = fsumw2->fN > 0;
+  if( errors && display->GetSumw2N() == 0 )
+    display->Sumw2();
+  TArrayD* dsumw2 = display->GetSumw2();
+  int nxf = full->GetNbinsX() + 1;
+  int nyf = is2d ? full->GetNbinsY() + 1 : 0;
+  for( int iy = 0; iy <= nyf; ++iy ) {
+    for( int ix = 0; ix <= nxf; ++ix ) {
+      Int_t bin = full->GetBin(ix, iy);
+      Int_t dbin = display->GetBin(e.xmap[ix], e.ymap[iy]);
+      display->AddBinContent(dbin, full->GetBinContent(bin));
+      if( errors )
+        dsumw2->fArray[dbin] += fsumw2->fArray[bin];
+    }
+  }
+  // Statistics of the full histogram, for the stats box
+  Double_t stats[TH1::kNstat] = {};
+  full->GetStats(stats);
+  display->PutStats(stats);
+  display->SetEntries(full->GetEntries());
+  return display;
+}
+
+//_____________________________________________________________________________
+TH1* DisplayCache::Replace( TVirtualPad* pad, int page, TH1* hist )
+{
+  if( !IsEnabled() || !pad || !hist || hist->GetNcells() <= fMaxBins )
+    return nullptr;
+  int dim = hist->GetDimension();
+  if( dim > 2 || hist->InheritsFrom("TProfile") ||
+      hist->InheritsFrom("TProfile2D") || hist->InheritsFrom("TH2Poly") ||
+      hist->GetXaxis()->GetLabels() ||
+      (dim == 2 && hist->GetYaxis()->GetLabels()) )
+    return nullptr;
+  TObjLink* lnk = FindLink(pad, hist);
+  if( !lnk )
+    return nullptr;
+  int px = 0, py = 0;
+  PlotPixels(pad, px, py);
+  // Not worth it unless there are at least two bins per pixel
+  if( hist->GetNbinsX() < 2 * px && (dim == 1 || hist->GetNbinsY() < 2 * py) )
+    return nullptr;
+
+  ostringstream sig;
+  sig << setprecision(17) << hist->GetName() << '\n' << hist->GetTitle()
+      << '\n' << hist->GetNcells() << ' ' << hist->GetEntries() << ' '
+      << hist->GetSumOfWeights() << ' ' << hist->TestBit(TH1::kNoStats)
+      << ' ' << px << ' ' << py;
+  Entry& e = fEntries[make_pair(page, pad->GetNumber())];
+  // A new draw starts unzoomed
+  int range[4] = {};
+  if( e.display )
+    GetRange(e.display.get(), range);
+  if( !e.display || e.sig != sig.str() || e.zoomed ||
+      !equal(range, range + 4, e.range) ) {
+    e.px = px;
+    e.py = py;
+    e.display.reset(MakeDisplay(hist, 1, hist->GetNbinsX(),
+                                1, dim == 2 ? hist->GetNbinsY() : 1, e));
+    e.sig = sig.str();
+    e.zoomed = false;
+    GetRange(e.display.get(), e.range);
+  }
+  e.full = hist;
+  lnk->SetObject(e.display.get());
+  return e.display.get();
+}
+
+//_____________________________________________________________________________
+bool DisplayCache::RangeChanged( TVirtualPad* pad, int page ) const
+{
+  if( !pad )
+    return false;
+  auto it = fEntries.find(make_pair(page, pad->GetNumber()));
+  if( it == fEntries.end() )
+    return false;
+  const Entry& e = it->second;
+  if( !e.full || !e.display || !FindLink(pad, e.display.get()) )
+    return false;
+  int range[4];
+  GetRange(e.display.get(), range);
+  return !equal(range, range + 4, e.range);
+}
+
+//_____________________________________________________________________________
+bool DisplayCache::Zoom( TVirtualPad* pad, int page )
+{
+  if( !RangeChanged(pad, page) )
+    return false;
+  Entry& e = fEntries[make_pair(page, pad->GetNumber())];
+  TObjLink* lnk = FindLink(pad, e.display.get());
+
+  int xfirst, xlast, yfirst = 1, ylast = 1;
+  VisibleBins(e.xmap, e.display->GetXaxis(), xfirst, xlast);
+  bool is2d = e.full->GetDimension() == 2;
+  if( is2d )
+    VisibleBins(e.ymap, e.display->GetYaxis(), yfirst, ylast);
+  unique_ptr<TH1> display(MakeDisplay(e.full, xfirst, xlast, yfirst, ylast,
+                                      e));
+  // Keep the zoom, now on the regrouped bins
+  e.zoomed = false;
+  if( xfirst > 1 || xlast < e.full->GetNbinsX() ) {
+    display->GetXaxis()->SetRange(e.xmap[xfirst], e.xmap[xlast]);
+    e.zoomed = true;
+  }
+  if( is2d && (yfirst > 1 || ylast < e.full->GetNbinsY()) ) {
+    display->GetYaxis()->SetRange(e.ymap[yfirst], e.ymap[ylast]);
+    e.zoomed = true;
+  }
+  lnk->SetObject(display.get());
+  e.display = std::move(display);
+  GetRange(e.display.get(), e.range);
+  pad->Modified();
+  return true;
+}
+
+//_____________________________________________________________________________
+TH1* DisplayCache::GetFull( TVirtualPad* pad, int page ) const
+{
+  // The full histogram is released with the pad's contents, so it is valid
+  // only as long as the pad still shows its copy
+  if( !pad )
+    return nullptr;
+  auto it = fEntries.find(make_pair(page, pad->GetNumber()));
+  if( it == fEntries.end() )
+    return nullptr;
+  const Entry& e = it->second;
+  if( !e.full || !e.display || !FindLink(pad, e.display.get()) )
+    return nullptr;
+  return e.full;
+}
+
+//_____________________________________________________________________________
+void DisplayCache::Drop( int page, int pad )
+{
+  auto it = fEntries.find(make_pair(page, pad));
+  if( it != fEntries.end() )
+    it->second.full = nullptr;
+}
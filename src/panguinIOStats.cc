@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////
+//  IOStats: per-pad/per-branch tree I/O statistics
+///////////////////////////////////////////////////////////////////
+
+#include "panguinIOStats.hh"
+#include <TTree.h>
+#include <TBranch.h>
+#include <TLeaf.h>
+#include <TObjArray.h>
+#include <TTreePerfStats.h>
+#include <TVirtualPerfStats.h>
+#include <TFile.h>
+#include <TString.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <set>
+
+using namespace std;
+
+static const double kMB = 1024. * 1024.;
+
+//_____________________________________________________________________________
+IOStats::IOStats() = default;
+
+//_____________________________________________________________________________
+IOStats::~IOStats()
+{
+  End();
+}
+
+//_____________________________________________________________________________
+void IOStats::Enable( const string& savefile )
+{
+  fEnabled = true;
+  fSaveFile = savefile;
+}
+
+//_____________________________________________________________________________
+void IOStats::Begin( TTree* tree, int page, int pad, const string& name )
+{
+  if( !fEnabled || !tree )
+    return;
+  End();
+  fTree = tree;
+  fCurrent = PadIO();
+  fCurrent.page = page;
+  fCurrent.pad = pad;
+  fCurrent.name = name;
+  fCurrent.tree = tree->GetName();
+  fPrevStats = gPerfStats;
+  fStats.reset(new TTreePerfStats(Form("ioperf_p%d_%d", page + 1, pad), tree));
+  fTree->SetPerfStats(fStats.get());
+  gPerfStats = fStats.get();
+}
+
+//_____________________________________________________________________________
+void IOStats::End()
+{
+  if( !fStats )
+    return;
+  fStats->Finish();
+  fTree->SetPerfStats(nullptr);
+  gPerfStats = fPrevStats;
+
+  fCurrent.bytes = fStats->GetBytesRead();
+  fCurrent.readcalls = fStats->GetReadCalls();
+  fCurrent.unziptime = fStats->GetUnzipTime();
+  fCurrent.disktime = fStats->GetDiskTime();
+  fCurrent.realtime = fStats->GetRealTime();
+
+  // Baskets read per branch. Only terminal branches (those holding leaves)
+  // have baskets.
+  set<TBranch*> seen;
+  TIter next(fTree->GetListOfLeaves());
+  while( auto* leaf = static_cast<TLeaf*>(next()) ) {
+    TBranch* br = leaf->GetBranch();
+    if( !br || !seen.insert(br).second )
+      continue;
+    BranchIO bio;
+    bio.name = br->GetName();
+    const Int_t* basketbytes = br->GetBasketBytes();
+    for( Int_t i = 0; i <= br->GetWriteBasket() && i < br->GetMaxBaskets(); ++i ) {
+      if( fStats->GetBasketInfo(br, i).fLoaded > 0 ) {
+        ++bio.baskets;
+        if( basketbytes )
+          bio.bytes += basketbytes[i];
+      }
+    }
+    if( bio.baskets > 0 ) {
+      fCurrent.baskets += bio.baskets;
+      fCurrent.branches.push_back(bio);
+    }
+  }
+  sort(fCurrent.branches.begin(), fCurrent.branches.end(),
+       []( const BranchIO& a, const BranchIO& b ) { return a.bytes > b.bytes; });
+  key_t key = make_pair(fCurrent.page, fCurrent.pad);
+  fPads[key] = fCurrent;
+
+  if( !fSaveFile.empty() )
+    fSaved[key] = std::move(fStats);
+  fStats.reset();
+  fTree = nullptr;
+}
+
+//_____________________________________________________________________________
+// Per-pad and per-branch statistics of the most recent draw of 'page',
+// followed by the page totals
+void IOStats::PrintPage( ostream& os, int page ) const
+{
+  auto it = fPads.lower_bound(make_pair(page, 0));
+  if( it == fPads.end() || it->first.first != page )
+    return;
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  PadIO total;
+  os << fixed << setprecision(3)
+     << "I/O for page " << page + 1 << ":" << endl
+     << "  pad   read[MB]  baskets  calls  unzip[s]  disk[s]   real[s]"
+     << "  tree: variable" << endl;
+  for( ; it != fPads.end() && it->first.first == page; ++it ) {
+    const PadIO& p = it->second;
+    os << "  " << setw(3) << p.pad
+       << setw(11) << p.bytes / kMB
+       << setw(9) << p.baskets
+       << setw(7) << p.readcalls
+       << setw(10) << p.unziptime
+       << setw(9) << p.disktime
+       << setw(10) << p.realtime
+       << "  " << p.tree << ": " << p.name << endl;
+    for( const auto& b: p.branches ) {
+      os << "        " << setw(11) << b.bytes / kMB
+         << setw(9) << b.baskets << "  " << b.name << endl;
+    }
+    total.bytes += p.bytes;
+    total.baskets += p.baskets;
+    total.readcalls += p.readcalls;
+    total.unziptime += p.unziptime;
+    total.disktime += p.disktime;
+    total.realtime += p.realtime;
+  }
+  os << "  all" << setw(11) << total.bytes / kMB
+     << setw(9) << total.baskets
+     << setw(7) << total.readcalls
+     << setw(10) << total.unziptime
+     << setw(9) << total.disktime
+     << setw(10) << total.realtime << endl;
+  os.flags(flags);
+  os.precision(prec);
+}
+
+//_____________________________________________________________________________
+// Totals per page and the branches read the most, over all pages
+void IOStats::PrintSummary( ostream& os ) const
+{
+  if( fPads.empty() )
+    return;
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  map<int, PadIO> pages;
+  map<string, BranchIO> branches;
+  for( const auto& entry: fPads ) {
+    const PadIO& p = entry.second;
+    PadIO& pg = pages[p.page];
+    pg.bytes += p.bytes;
+    pg.baskets += p.baskets;
+    pg.readcalls += p.readcalls;
+    pg.unziptime += p.unziptime;
+    pg.disktime += p.disktime;
+    pg.realtime += p.realtime;
+    for( const auto& b: p.branches ) {
+      BranchIO& bio = branches[p.tree + "." + b.name];
+      bio.bytes += b.bytes;
+      bio.baskets += b.baskets;
+    }
+  }
+  os << fixed << setprecision(3)
+     << "I/O summary:" << endl
+     << "  page   read[MB]  baskets  calls  unzip[s]  disk[s]   real[s]" << endl;
+  for( const auto& entry: pages ) {
+    const PadIO& pg = entry.second;
+    os << "  " << setw(4) << entry.first + 1
+       << setw(11) << pg.bytes / kMB
+       << setw(9) << pg.baskets
+       << setw(7) << pg.readcalls
+       << setw(10) << pg.unziptime
+       << setw(9) << pg.disktime
+       << setw(10) << pg.realtime << endl;
+  }
+  vector<pair<string, BranchIO>> sorted(branches.begin(), branches.end());
+  sort(sorted.begin(), sorted.end(),
+       []( const pair<string, BranchIO>& a, const pair<string, BranchIO>& b ) {
+         return a.second.bytes > b.second.bytes;
+       });
+  const size_t ntop = 10;
+  os << "  Branches read most:" << endl;
+  for( size_t i = 0; i < min(ntop, sorted.size()); ++i ) {
+    os << "    " << setw(11) << sorted[i].second.bytes / kMB << " MB"
+       << setw(7) << sorted[i].second.baskets << " baskets  "
+       << sorted[i].first << endl;
+  }
+  os.flags(flags);
+  os.precision(prec);
+}
+
+//_____________________________________________________________________________
+// Write the kept TTreePerfStats objects to the save file, if requested
+int IOStats::Finish()
+{
+  End();
+  if( fSaveFile.empty() || fSaved.empty() )
+    return 0;
+  TFile f(fSaveFile.c_str(), "RECREATE");
+  if( !f.IsOpen() ) {
+    cerr << "ERROR: Cannot open I/O statistics file " << fSaveFile << endl;
+    return 1;
+  }
+  for( const auto& entry: fSaved )
+    f.WriteTObject(entry.second.get());
+  f.Close();
+  cout << "I/O statistics of " << fSaved.size() << " tree draws written to "
+       << fSaveFile << endl;
+  fSaved.clear();
+  return 0;
+}
@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////
+//  JsonOutput: pads as ROOT JSON with a manifest for delta updates
+///////////////////////////////////////////////////////////////////
+
+#include "panguinJson.hh"
+#include "panguinOnlineConfig.hh"  // JsonQuote
+#include <TBufferJSON.h>
+#include <TVirtualPad.h>
+#include <TSystem.h>
+#include <TString.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <functional>
+#include <cstdio>
+#include <ctime>
+
+using namespace std;
+
+// Compact JSON without spaces, with repeated objects stored as references,
+// as used by THttpServer for JSROOT
+static const Int_t kJsonCompact = 23;
+
+//_____________________________________________________________________________
+void JsonOutput::SetDirectory( const string& dir )
+{
+  if( dir == fDir )
+    return;
+  fDir = dir;
+  fPages.clear();
+  if( !fDir.empty() )
+    gSystem->mkdir(fDir.c_str(), true);
+}
+
+//_____________________________________________________________________________
+void JsonOutput::BeginPage( int page, const string& title, int nx, int ny,
+                            int run )
+{
+  fPage = page;
+  fWritten = 0;
+  fChanged = false;
+  if( !IsEnabled() )
+    return;
+  PageEntry& pg = fPages[page];
+  if( pg.title != title || pg.nx != nx || pg.ny != ny || run != fRun ) {
+    pg.title = title;
+    pg.nx = nx;
+    pg.ny = ny;
+    pg.pads.clear();
+    fRun = run;
+    fChanged = true;
+  }
+}
+
+//_____________________________________________________________________________
+void JsonOutput::AddPad( int pad, const string& name, TVirtualPad* vpad )
+{
+  if( !IsEnabled() || fPage < 0 || !vpad )
+    return;
+  string json = TBufferJSON::ConvertToJSON(vpad, kJsonCompact).Data();
+  size_t hash = std::hash<string>()(json);
+  PageEntry& pg = fPages[fPage];
+  PadEntry& entry = pg.pads[pad];
+  if( entry.seq != 0 && entry.hash == hash && entry.name == name )
+    return;
+
+  ostringstream ostr;
+  ostr << "page" << setw(2) << setfill('0') << fPage + 1
+       << "_pad" << setw(2) << setfill('0') << pad << ".json";
+  entry.name = name;
+  entry.file = ostr.str();
+  entry.hash = hash;
+  entry.seq = fSeq + 1;
+  pg.seq = fSeq + 1;
+  if( WriteFile(entry.file, json) == 0 )
+    ++fWritten;
+  fChanged = true;
+}
+
+//_____________________________________________________________________________
+int JsonOutput::EndPage()
+{
+  if( !IsEnabled() || fPage < 0 )
+    return 0;
+  if( fChanged ) {
+    ++fSeq;
+    fPages[fPage].seq = fSeq;
+    WriteManifest();
+  }
+  fPage = -1;
+  return fWritten;
+}
+
+//_____________________________________________________________________________
+// Write 'content' to 'name' in the output directory via a temporary file,
+// so that readers never see a partially written file
+int JsonOutput::WriteFile( const string& name, const string& content ) const
+{
+  string path = fDir + "/" + name;
+  string tmp = path + ".tmp";
+  {
+    ofstream ofs(tmp);
+    if( !ofs ) {
+      cerr << "ERROR: Cannot write JSON output file " << tmp << endl;
+      return 1;
+    }
+    ofs << content << endl;
+  }
+  if( rename(tmp.c_str(), path.c_str()) != 0 ) {
+    cerr << "ERROR: Cannot rename " << tmp << " to " << path << endl;
+    return 1;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+int JsonOutput::WriteManifest() const
+{
+  ostringstream os;
+  os << "{" << endl
+     << "  \"seq\": " << fSeq << "," << endl
+     << "  \"run\": " << fRun << "," << endl
+     << "  \"updated\": " << time(nullptr) << "," << endl
+     << "  \"pages\": [";
+  const char* psep = "";
+  for( const auto& pe: fPages ) {
+    const PageEntry& pg = pe.second;
+    os << psep << endl
+       << "    {\"page\": " << pe.first + 1
+       << ", \"title\": " << JsonQuote(pg.title)
+       << ", \"nx\": " << pg.nx << ", \"ny\": " << pg.ny
+       << ", \"seq\": " << pg.seq << "," << endl
+       << "     \"pads\": [";
+    const char* sep = "";
+    for( const auto& entry: pg.pads ) {
+      const PadEntry& pad = entry.second;
+      os << sep << endl
+         << "       {\"pad\": " << entry.first
+         << ", \"name\": " << JsonQuote(pad.name)
+         << ", \"file\": " << JsonQuote(pad.file)
+         << ", \"seq\": " << pad.seq << "}";
+      sep = ",";
+    }
+    os << "]}";
+    psep = ",";
+  }
+  os << endl << "  ]" << endl << "}";
+  return WriteFile("manifest.json", os.str());
+}
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////
+//  OutputManifest: content digests of written images and pages
+///////////////////////////////////////////////////////////////////
+
+#include "panguinManifest.hh"
+#include "panguinOnlineConfig.hh"  // HashDigest
+#include <TBufferJSON.h>
+#include <TObject.h>
+#include <TSystem.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+using namespace std;
+
+//_____________________________________________________________________________
+void OutputManifest::SetFile( const string& filename )
+{
+  if( filename == fFileName )
+    return;
+  fFileName = filename;
+  fDigests.clear();
+  fDirty = false;
+  if( fFileName.empty() )
+    return;
+  // One line per output: digest, then path (which may contain blanks)
+  ifstream ifs(fFileName);
+  string line;
+  while( getline(ifs, line) ) {
+    auto pos = line.find(' ');
+    if( pos == string::npos || pos + 1 >= line.size() )
+      continue;
+    fDigests[line.substr(pos + 1)] = line.substr(0, pos);
+  }
+}
+
+//_____________________________________________________________________________
+string OutputManifest::Digest( const TObject* obj, const string& extra )
+{
+  string data = obj ? TBufferJSON::ConvertToJSON(obj).Data() : "";
+  data += '\0';
+  data += extra;
+  return HashDigest(data);
+}
+
+//_____________________________________________________________________________
+bool OutputManifest::IsUnchanged( const string& path, const string& digest )
+{
+  if( !IsEnabled() )
+    return false;
+  auto it = fDigests.find(path);
+  if( it == fDigests.end() || it->second != digest ||
+      gSystem->AccessPathName(path.c_str()) )
+    return false;
+  ++fSkipped;
+  return true;
+}
+
+//_____________________________________________________________________________
+void OutputManifest::Update( const string& path, const string& digest )
+{
+  if( !IsEnabled() )
+    return;
+  ++fWritten;
+  string& stored = fDigests[path];
+  if( stored != digest ) {
+    stored = digest;
+    fDirty = true;
+  }
+}
+
+//_____________________________________________________________________________
+int OutputManifest::Save()
+{
+  if( !IsEnabled() || !fDirty )
+    return 0;
+  string tmp = fFileName + ".tmp";
+  {
+    ofstream ofs(tmp);
+    if( !ofs ) {
+      cerr << "ERROR: Cannot write output manifest " << tmp << endl;
+      return 1;
+    }
+    for( const auto& entry: fDigests )
+      ofs << entry.second << " " << entry.first << endl;
+  }
+  if( rename(tmp.c_str(), fFileName.c_str()) != 0 ) {
+    cerr << "ERROR: Cannot rename " << tmp << " to " << fFileName << endl;
+    return 1;
+  }
+  fDirty = false;
+  return 0;
+}
+
+//_____________________________________________________________________________
+void OutputManifest::PrintSummary( ostream& os ) const
+{
+  if( !IsEnabled() )
+    return;
+  os << "Output files: " << fWritten << " written, " << fSkipped
+     << " unchanged and skipped" << endl;
+}
@@ -0,0 +1,323 @@
+///////////////////////////////////////////////////////////////////
+//  MemoryAccount: per-page/per-pad memory bookkeeping
+///////////////////////////////////////////////////////////////////
+
+#include "panguinMemory.hh"
+#include "panguinOnlineConfig.hh"  // JsonQuote
+#include <TSystem.h>
+#include <TClass.h>
+#include <TList.h>
+#include <TVirtualPad.h>
+#include <TH1.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TProfile3D.h>
+#include <TGraph.h>
+#include <TTree.h>
+#include <TVirtualTreePlayer.h>
+#include <TSelectorDraw.h>
+#include <TEntryList.h>
+#include <TEventList.h>
+#include <TArrayC.h>
+#include <TArrayS.h>
+#include <TArrayI.h>
+#include <TArrayF.h>
+#include <TArrayD.h>
+#include <TArrayL64.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+static const double kMB = 1024. * 1024.;
+
+//_____________________________________________________________________________
+long long PageMemory::Total() const
+{
+  long long sum = 0;
+  for( const auto& pad: pads )
+    sum += pad.Total();
+  return sum;
+}
+
+//_____________________________________________________________________________
+// Resident memory of this process in kB
+long MemoryAccount::GetRSS()
+{
+  ProcInfo_t info;
+  if( gSystem->GetProcInfo(&info) != 0 )
+    return 0;
+  return info.fMemResident;
+}
+
+//_____________________________________________________________________________
+// Approximate size of the bin storage of 'hist' plus the object itself
+long long MemoryAccount::HistBytes( const TH1* hist )
+{
+  if( !hist )
+    return 0;
+  long long ncells = hist->GetNcells();
+  long long bytes = hist->IsA()->Size();
+  if( dynamic_cast<const TArrayD*>(hist) || dynamic_cast<const TArrayL64*>(hist) )
+    bytes += 8 * ncells;
+  else if( dynamic_cast<const TArrayF*>(hist) || dynamic_cast<const TArrayI*>(hist) )
+    bytes += 4 * ncells;
+  else if( dynamic_cast<const TArrayS*>(hist) )
+    bytes += 2 * ncells;
+  else if( dynamic_cast<const TArrayC*>(hist) )
+    bytes += ncells;
+  bytes += 8LL * hist->GetSumw2N();
+
+  // Profiles keep bin entries and, optionally, their sum of weights squared
+  const TArrayD* binsumw2 = nullptr;
+  if( auto* p = dynamic_cast<const TProfile*>(hist) )
+    binsumw2 = p->GetBinSumw2();
+  else if( auto* p2 = dynamic_cast<const TProfile2D*>(hist) )
+    binsumw2 = p2->GetBinSumw2();
+  else if( auto* p3 = dynamic_cast<const TProfile3D*>(hist) )
+    binsumw2 = p3->GetBinSumw2();
+  if( binsumw2 )
+    bytes += 8 * (ncells + binsumw2->GetSize());
+
+  return bytes;
+}
+
+//_____________________________________________________________________________
+// Total size of the histograms and graphs displayed in 'pad' and its subpads
+long long MemoryAccount::PadHistBytes( TVirtualPad* pad )
+{
+  if( !pad || !pad->GetListOfPrimitives() )
+    return 0;
+  long long bytes = 0;
+  TIter next(pad->GetListOfPrimitives());
+  while( TObject* obj = next() ) {
+    if( auto* hist = dynamic_cast<TH1*>(obj) ) {
+      bytes += HistBytes(hist);
+    } else if( auto* graph = dynamic_cast<TGraph*>(obj) ) {
+      long long n = graph->GetN();
+      int narrays = 2;
+      for( const auto* a: {graph->GetEX(), graph->GetEY(),
+                           graph->GetEXlow(), graph->GetEXhigh(),
+                           graph->GetEYlow(), graph->GetEYhigh()} ) {
+        if( a ) ++narrays;
+      }
+      bytes += graph->IsA()->Size() + 8 * n * narrays;
+    } else if( auto* subpad = dynamic_cast<TVirtualPad*>(obj) ) {
+      bytes += PadHistBytes(subpad);
+    }
+  }
+  return bytes;
+}
+
+//_____________________________________________________________________________
+// Size of the value buffers TTree::Draw allocated for the last draw from
+// 'tree'. These are kept until the next draw.
+long long MemoryAccount::DrawBufferBytes( TTree* tree )
+{
+  if( !tree || !tree->GetPlayer() )
+    return 0;
+  auto* sel = dynamic_cast<TSelectorDraw*>(tree->GetPlayer()->GetSelector());
+  if( !sel )
+    return 0;
+  int nbuf = 0;
+  for( int i = 0; i < sel->GetDimension(); ++i ) {
+    if( sel->GetVal(i) )
+      ++nbuf;
+  }
+  if( sel->GetW() )
+    ++nbuf;
+  return 8LL * nbuf * tree->GetEstimate();
+}
+
+//_____________________________________________________________________________
+// Approximate size of an entry list or event list
+long long MemoryAccount::EntryListBytes( const TObject* obj )
+{
+  if( auto* elist = dynamic_cast<const TEntryList*>(obj) )
+    return elist->IsA()->Size() + 2 * elist->GetN();
+  if( auto* evlist = dynamic_cast<const TEventList*>(obj) )
+    return evlist->IsA()->Size() + 8 * evlist->GetN();
+  return 0;
+}
+
+//_____________________________________________________________________________
+void MemoryAccount::Sample( long rss )
+{
+  fCurrent.rss_peak = max(fCurrent.rss_peak, rss);
+  fPeakRSS = max(fPeakRSS, rss);
+}
+
+//_____________________________________________________________________________
+void MemoryAccount::BeginPage( int page, const string& title )
+{
+  fCurrent = PageMemory();
+  fCurrent.page = page;
+  fCurrent.title = title;
+  fCurrent.rss_start = GetRSS();
+  fInPad = false;
+  Sample(fCurrent.rss_start);
+}
+
+//_____________________________________________________________________________
+void MemoryAccount::BeginPad( int pad, const string& name )
+{
+  PadMemory pm;
+  pm.pad = pad;
+  pm.name = name;
+  pm.rss_before = GetRSS();
+  Sample(pm.rss_before);
+  fCurrent.pads.push_back(pm);
+  fInPad = true;
+}
+
+//_____________________________________________________________________________
+void MemoryAccount::EndPad( TVirtualPad* pad )
+{
+  if( !fInPad )
+    return;
+  PadMemory& pm = fCurrent.pads.back();
+  pm.hists = PadHistBytes(pad);
+  pm.rss_after = GetRSS();
+  Sample(pm.rss_after);
+  fInPad = false;
+}
+
+//_____________________________________________________________________________
+void MemoryAccount::EndPage()
+{
+  fInPad = false;
+  fCurrent.rss_end = GetRSS();
+  Sample(fCurrent.rss_end);
+  if( fCurrent.page >= 0 )
+    fPages[fCurrent.page] = fCurrent;
+}
+
+//_____________________________________________________________________________
+PadMemory* MemoryAccount::CurrentPad()
+{
+  return fInPad ? &fCurrent.pads.back() : nullptr;
+}
+
+//_____________________________________________________________________________
+void MemoryAccount::Clear()
+{
+  fPages.clear();
+  fCurrent = PageMemory();
+  fInPad = false;
+  fPeakRSS = 0;
+}
+
+//_____________________________________________________________________________
+const PageMemory* MemoryAccount::GetPage( int page ) const
+{
+  auto it = fPages.find(page);
+  return it != fPages.end() ? &it->second : nullptr;
+}
+
+//_____________________________________________________________________________
+void MemoryAccount::Print( ostream& os, const PageMemory& page ) const
+{
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  os << fixed << setprecision(2)
+     << "Memory for page " << page.page + 1 << " (" << page.title << "): "
+     << page.Total() / kMB << " MB in pads, RSS "
+     << page.rss_start / 1024. << " -> " << page.rss_end / 1024.
+     << " MB, peak " << page.rss_peak / 1024. << " MB" << endl
+     << "  pad     hists[MB]  drawbuf[MB]  elists[MB]  cache[MB]"
+     << "  dRSS[MB]  name" << endl;
+  for( const auto& pad: page.pads ) {
+    os << "  " << setw(3) << pad.pad
+       << setw(14) << pad.hists / kMB
+       << setw(13) << pad.drawbuf / kMB
+       << setw(12) << pad.entrylists / kMB
+       << setw(11) << pad.cache / kMB
+       << setw(10) << (pad.rss_after - pad.rss_before) / 1024.
+       << "  " << pad.name << endl;
+  }
+  os.flags(flags);
+  os.precision(prec);
+}
+
+//_____________________________________________________________________________
+// Short per-page overview followed by the pads using the most memory
+void MemoryAccount::PrintSummary( ostream& os ) const
+{
+  if( fPages.empty() )
+    return;
+  const size_t ntop = 5;
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  os << fixed << setprecision(2)
+     << "Memory summary (peak RSS " << fPeakRSS / 1024. << " MB):" << endl
+     << "  page   pads[MB]  peakRSS[MB]  title" << endl;
+  vector<pair<const PageMemory*, const PadMemory*>> all;
+  for( const auto& entry: fPages ) {
+    const PageMemory& page = entry.second;
+    os << "  " << setw(4) << page.page + 1
+       << setw(11) << page.Total() / kMB
+       << setw(13) << page.rss_peak / 1024.
+       << "  " << page.title << endl;
+    for( const auto& pad: page.pads )
+      all.emplace_back(&page, &pad);
+  }
+  size_t n = min(ntop, all.size());
+  partial_sort(all.begin(), all.begin() + n, all.end(),
+               []( const pair<const PageMemory*, const PadMemory*>& a,
+                   const pair<const PageMemory*, const PadMemory*>& b ) {
+                 return a.second->Total() > b.second->Total();
+               });
+  os << "  Largest pads:" << endl;
+  for( size_t i = 0; i < n; ++i ) {
+    os << "    page " << all[i].first->page + 1
+       << " pad " << all[i].second->pad << ": "
+       << all[i].second->Total() / kMB << " MB  "
+       << all[i].second->name << endl;
+  }
+  os.flags(flags);
+  os.precision(prec);
+}
+
+//_____________________________________________________________________________
+int MemoryAccount::WriteJSON( const string& filename ) const
+{
+  ofstream ofs(filename);
+  if( !ofs ) {
+    cerr << "ERROR: Cannot open memory report file " << filename << endl;
+    return 1;
+  }
+  ofs << "{" << endl
+      << "  \"peak_rss_kb\": " << fPeakRSS << "," << endl
+      << "  \"pages\": [";
+  const char* psep = "";
+  for( const auto& entry: fPages ) {
+    const PageMemory& page = entry.second;
+    ofs << psep << endl
+        << "    {\"page\": " << page.page + 1
+        << ", \"title\": " << JsonQuote(page.title)
+        << ", \"bytes\": " << page.Total()
+        << ", \"rss_start_kb\": " << page.rss_start
+        << ", \"rss_end_kb\": " << page.rss_end
+        << ", \"rss_peak_kb\": " << page.rss_peak
+        << ", \"pads\": [";
+    const char* sep = "";
+    for( const auto& pad: page.pads ) {
+      ofs << sep << endl
+          << "      {\"pad\": " << pad.pad
+          << ", \"name\": " << JsonQuote(pad.name)
+          << ", \"hist_bytes\": " << pad.hists
+          << ", \"drawbuf_bytes\": " << pad.drawbuf
+          << ", \"entrylist_bytes\": " << pad.entrylists
+          << ", \"cache_bytes\": " << pad.cache
+          << ", \"rss_before_kb\": " << pad.rss_before
+          << ", \"rss_after_kb\": " << pad.rss_after << "}";
+      sep = ",";
+    }
+    ofs << endl << "    ]}";
+    psep = ",";
+  }
+  ofs << endl << "  ]" << endl << "}" << endl;
+  return 0;
+}
@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////////
 
 #include "panguinOnline.hh"
+#include "panguinCompare.hh"
 #include <TBranch.h>
 #include <TGClient.h>
 #include <TCanvas.h>
@@ -12,24 +13,40 @@
 #include <TGImageMap.h>
 #include <TGFileDialog.h>
 #include <TKey.h>
+#include <TQObject.h>
 #include <TSystem.h>
 #include <TLatex.h>
+#include <TPad.h>
+#include <TGraph.h>
 #include "TPaveText.h"
 #include <TApplication.h>
 #include "TEnv.h"
 #include "TRegexp.h"
 #include "TGaxis.h"
+#include <TH2F.h>
+#include <TH3F.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <THLimitsFinder.h>
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <set>
 #include <sys/stat.h>
 #include <ctime>
 #include <utility>
 #include <cassert>
 #include <memory>
 #include <type_traits>  // std::make_signed
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <fstream>
+#include <csignal>
+#include <limits>
+#include <cmath>
 
 #define OLDTIMERUPDATE
 
@@ -37,6 +54,8 @@ ClassImp(OnlineGUI)
 
 using namespace std;
 
+static const Int_t kDensityBins = 200;  // Minimum bins per axis of density maps
+
 template<typename T>
 static inline
 typename std::make_signed<T>::type SINT(T uint) {
@@ -68,19 +87,19 @@ static void SetupPad( const OnlineGUI::cmdmap_t& command )
 }
 
 //_____________________________________________________________________________
-// Make a temporary canvas in batch mode for drawing images to be saved
-static unique_ptr<TCanvas> MakeCanvas( const char* name = "c" )
+// Settings that affect an image of the current pad besides its contents:
+// draw option, axis scales, grid and size. Part of the output digest.
+static string PadSettings( const OnlineGUI::cmdmap_t& command )
 {
-  auto ww = gPad->GetWw(), hh = gPad->GetWh();
-#if __cplusplus >= 201402L
-  auto c = make_unique<TCanvas>(name, name, ww, hh);
-#else
-  auto c = unique_ptr<TCanvas>(
-                new TCanvas(name, name, gPad->GetWw(), gPad->GetWh()));
-#endif
-  c->SetBatch();
-  c->SetCanvasSize(ww, hh);
-  return c;
+  ostringstream ostr;
+  ostr << getMapVal(command, "drawopt");
+  for( const char* key: {"logx", "logy", "logz"} ) {
+    if( command.find(key) != command.end() )
+      ostr << " " << key;
+  }
+  ostr << " " << getMapVal(command, "grid")
+       << " " << gPad->GetWw() << "x" << gPad->GetWh();
+  return ostr.str();
 }
 
 //_____________________________________________________________________________
@@ -97,6 +116,113 @@ static int MakePlotsDir( const string& dir )
   return 0;
 }
 
+//_____________________________________________________________________________
+// Check if 'pad' contains a graph, as drawn by TTree::Draw for scatter plots
+static bool HasGraph( TVirtualPad* pad )
+{
+  if( !pad )
+    return false;
+  TIter next(pad->GetListOfPrimitives());
+  while( TObject* obj = next() ) {
+    if( obj->InheritsFrom("TGraph") )
+      return true;
+  }
+  return false;
+}
+
+//_____________________________________________________________________________
+// The expressions of a multi-dimensional draw 'var', i.e. the parts separated
+// by ':' that is not part of '::'
+static vector<TString> SplitDimensions( const TString& var )
+{
+  vector<TString> dims;
+  Ssiz_t start = 0;
+  for( Ssiz_t i = 0; i < var.Length(); ++i ) {
+    if( var[i] != ':' )
+      continue;
+    if( i + 1 < var.Length() && var[i + 1] == ':' ) {
+      ++i;
+      continue;
+    }
+    dims.emplace_back(var(start, i - start));
+    start = i + 1;
+  }
+  dims.emplace_back(var(start, var.Length() - start));
+  return dims;
+}
+
+//_____________________________________________________________________________
+// Whether TTree::Draw of 'var' with option 'opt' makes a 2D scatter plot,
+// i.e. a graph of all selected points
+static bool IsScatter( const TString& var, const string& opt )
+{
+  if( var.Contains(">>") )
+    return false;
+  // Exactly one ':' that is not part of '::'
+  if( SplitDimensions(var).size() != 2 )
+    return false;
+  TString o = opt.c_str();
+  o.ToLower();
+  o.ReplaceAll("scat", "");
+  o.ReplaceAll(" ", "");
+  return o.IsNull();
+}
+
+//_____________________________________________________________________________
+// Whether 'opt' makes TTree::Draw of two or three variables fill and draw a
+// 2D or 3D histogram, rather than a graph or profile
+static bool IsHistOption( const string& opt )
+{
+  TString o = opt.c_str();
+  o.ToLower();
+  if( o.Contains("prof") )
+    return false;
+  for( const char* h: {"col", "cont", "box", "lego", "surf", "text", "arr",
+                       "iso"} ) {
+    if( o.Contains(h) )
+      return true;
+  }
+  return false;
+}
+
+//_____________________________________________________________________________
+// Range of each of the expressions of a multi-dimensional draw over the
+// entries of 'tree' passing 'cut', read 'chunk' entries at a time, so that
+// at most about 'chunk' values per expression are held in memory. Ranges are
+// in the order of the histogram axes (x first, i.e. the last expression).
+// Returns the number of values found, or -1 on error.
+static Long64_t ScanRanges( TTree* tree, const TString& var, const TCut& cut,
+                            Int_t ndim, Long64_t chunk,
+                            vector<Double_t>& vmin, vector<Double_t>& vmax )
+{
+  vmin.assign(ndim, numeric_limits<Double_t>::max());
+  vmax.assign(ndim, numeric_limits<Double_t>::lowest());
+  Long64_t nentries = tree->GetEntries(), nfound = 0;
+  tree->SetEstimate(chunk);
+  Long64_t nread = chunk;
+  for( Long64_t first = 0; first < nentries; ) {
+    Long64_t n = tree->Draw(var, cut, "goff", nread, first);
+    if( n < 0 )
+      return -1;
+    if( n > tree->GetEstimate() && nread > 1 ) {
+      // Array variables: more values than entries. Try fewer entries.
+      nread = max(nread / 2, Long64_t(1));
+      continue;
+    }
+    n = min(n, tree->GetEstimate());
+    for( Int_t a = 0; a < ndim; ++a ) {
+      const Double_t* v = tree->GetVal(ndim - 1 - a);
+      for( Long64_t i = 0; i < n; ++i ) {
+        vmin[a] = min(vmin[a], v[i]);
+        vmax[a] = max(vmax[a], v[i]);
+      }
+    }
+    nfound += n;
+    first += nread;
+  }
+  return nfound;
+}
+
 //_____________________________________________________________________________
 // Get file basename without extension (erase starting from first '.')
 static inline string StripExtension( string str )
@@ -173,7 +299,22 @@ OnlineGUI::OnlineGUI( OnlineConfig config )
     }
   }
 
-  if( PrepareRootFiles() )
+  if( !fConfig.GetProfileFile().empty() )
+    fProfiler.Enable(fConfig.GetProfileFile());
+  if( fConfig.DoIOStats() )
+    fIOStats.Enable(fConfig.GetIOStatsFile());
+  if( !fConfig.GetOutputManifest().empty() )
+    fManifest.SetFile(fConfig.GetOutputManifest());
+  fDisplay.SetMaxBins(fConfig.GetDisplayMaxBins());
+  fAlarmLog.SetFile(fConfig.GetAlarmLog());
+  if( !fConfig.GetTrendFile().empty() ) {
+    fTrend.SetFile(fConfig.GetTrendFile());
+    if( !fConfig.GetTrendQuantiles().empty() )
+      fTrend.SetQuantiles(fConfig.GetTrendQuantiles());
+  }
+
+  // In a multi-run job or the daemon, the file of each run is opened in turn
+  if( !fConfig.IsMultiRun() && !fConfig.IsDaemon() && PrepareRootFiles() )
     throw runtime_error("Error opening ROOT file");
 
   if( !fPrintOnly )
@@ -182,7 +323,7 @@ OnlineGUI::OnlineGUI( OnlineConfig config )
 
 void OnlineGUI::CreateGUI( const TGWindow* p, UInt_t w, UInt_t h )
 {
-  if( !fRootFile )
+  if( !fRootFile && !fMapFile )
     throw runtime_error("No ROOT file");
 
   // Create the main frame
@@ -330,6 +471,16 @@ void OnlineGUI::CreateGUI( const TGWindow* p, UInt_t w, UInt_t h )
   fPrint->Connect("Clicked()", "OnlineGUI", this, "PrintToFile()");
   hframe->AddFrame(fPrint, new TGLayoutHints(kLHintsCenterX, 5, 5, 1, 1));
 
+  // Redo display copies of large histograms at the resolution of a zoom
+  if( fDisplay.IsEnabled() ) {
+    fZoomTimer = new TTimer();
+    TTimer::Connect(fZoomTimer, "Timeout()", "OnlineGUI", this, "ApplyZoom()");
+    TQObject::Connect("TPad", "RangeAxisChanged()", "OnlineGUI", this,
+                      "DisplayZoomed()");
+    TQObject::Connect("TPad", "UnZoomed()", "OnlineGUI", this,
+                      "DisplayZoomed()");
+  }
+
 
   // Set a name to the main frame
   if( fConfig.IsMonitor() ) {
@@ -344,8 +495,10 @@ void OnlineGUI::CreateGUI( const TGWindow* p, UInt_t w, UInt_t h )
   // Initialize the layout algorithm
   fMain->Resize(fMain->GetDefaultSize());
 
-  // Map main frame
+  // Map main frame, and show it before the first page is drawn
   fMain->MapWindow();
+  gSystem->ProcessEvents();
+  StartupTimer::Instance().Mark("create GUI");
 
   if( fVerbosity >= 1 )
     fMain->Print();
@@ -354,6 +507,8 @@ void OnlineGUI::CreateGUI( const TGWindow* p, UInt_t w, UInt_t h )
     DoDraw();
 
   if( fConfig.IsMonitor() ) {
+    if( fFileAlive )
+      UpdateAlarms();
     timerNow = new TTimer();
     TTimer::Connect(timerNow, "Timeout()", "OnlineGUI", this, "UpdateCurrentTime()");
     timerNow->Start(1000);  // update every second
@@ -364,7 +519,7 @@ void OnlineGUI::CreateGUI( const TGWindow* p, UInt_t w, UInt_t h )
     } else {
       TTimer::Connect(timer, "Timeout()", "OnlineGUI", this, "CheckRootFile()");
     }
-    timer->Start(UPDATETIME);
+    timer->Start(GetUpdateInterval());
   }
 
 }
@@ -420,40 +575,114 @@ void OnlineGUI::DoDraw()
   if( fVerbosity >= 1 )
     cout << "Dimensions: " << nx << "X" << ny << endl;
 
-  // Create a nice clean canvas.
-  fCanvas->Clear();
-  fCanvas->Divide(nx, ny);
+  // On watchfile updates, keep the pads whose inputs did not change since
+  // this page was drawn (see GetPadInputs)
+  Bool_t track = fConfig.IsMonitor() && !fPrintOnly;
+  Bool_t incremental = track && fOnlyChanged && fDrawnPage == current_page;
+  const string confver = track ? fConfig.GetConfigDigest() : string();
+  Int_t nredrawn = 0;
+
+  if( !incremental ) {
+    // Create a nice clean canvas. Release whatever we drew last time only
+    // after the pads no longer display it.
+    fCanvas->Clear();
+    fArena.ReleaseAll();
+    fCanvas->Divide(nx, ny);
+    fPadInputs.clear();
+  }
 
   cmdmap_t drawcommand;
   //keys are "variable", "cut", "drawopt", "title", "treename", "grid", "nostat"
 
   // Draw the histograms.
+  Profiler::Span pagespan(fProfiler, "page", current_page);
+  fMemory.BeginPage(current_page, fConfig.GetPageTitle(current_page));
+  vector<string> padnames(draw_count);
   for( Int_t i = 0; i < SINT(draw_count); i++ ) {
     current_pad = i + 1;
     fConfig.GetDrawCommand(current_page, current_pad - 1, drawcommand);
-    fCanvas->cd(current_pad);
 
     const string& cmd = getMapVal(drawcommand, "variable");
+    const string& padname = cmd == "macro" ? getMapVal(drawcommand, "macro")
+                                           : cmd;
+    padnames[i] = padname;
+    if( track ) {
+      string inputs = GetPadInputs(drawcommand);
+      if( !inputs.empty() )
+        inputs += " " + confver;
+      string& drawn = fPadInputs[current_pad];
+      if( incremental && !inputs.empty() && inputs == drawn )
+        continue;
+      drawn = inputs;
+      if( incremental ) {
+        fCanvas->GetPad(current_pad)->Clear();
+        fDisplay.Drop(current_page, current_pad);
+        fArena.Release(current_page, current_pad);
+      }
+    }
+    ++nredrawn;
+    fCanvas->cd(current_pad);
+    Profiler::Span padspan(fProfiler, "pad", current_page, current_pad,
+                           padname.c_str());
+    fImageFile.clear();
+    fMemory.BeginPad(current_pad, padname);
+    TH1* padhist = nullptr;
     if( !cmd.empty() ) {
       if( cmd == "macro" ) {
-        SaveMacroImage(drawcommand);
         MacroDraw(drawcommand);
+        SaveImage(drawcommand);
       } else if( cmd == "loadmacro" ) {
         LoadDraw(drawcommand);
       } else if( cmd == "loadlib" ) {
         LoadLib(drawcommand);
+      } else if( cmd == "trend" ) {
+        TrendDraw(drawcommand);
+      } else if( cmd == "stripchart" ) {
+        StripChartDraw(drawcommand);
       } else if( IsHistogram(cmd) ) {
-        HistDraw(drawcommand);
+        padhist = HistDraw(drawcommand);
       } else {
-        TreeDraw(drawcommand);
+        padhist = TreeDraw(drawcommand);
       }
     }
+    if( fRecordTrend && padhist )
+      fTrend.Add(runNumber, current_page + 1, current_pad,
+                 GetPadIdentity(drawcommand).Data(), padname, padhist);
+    SavePadImage(drawcommand);
+    fMemory.EndPad(fCanvas->GetPad(current_pad));
   }
 
   fCanvas->cd();
-  fCanvas->Update();
+  {
+    Profiler::Span paintspan(fProfiler, "paint", current_page);
+    fCanvas->Update();
+  }
+  fDrawnPage = current_page;
+  if( incremental && fVerbosity >= 1 )
+    cout << "Update: " << nredrawn << " of " << draw_count
+         << " pads redrawn" << endl;
+  fMemory.EndPage();
+  if( !fConfig.GetJsonDir().empty() ) {
+    Profiler::Span jsonspan(fProfiler, "json", current_page);
+    fJson.SetDirectory(SubstitutePlaceholders(fConfig.GetJsonDir()));
+    fJson.BeginPage(current_page, fConfig.GetPageTitle(current_page), nx, ny,
+                    runNumber);
+    for( Int_t i = 0; i < SINT(draw_count); i++ )
+      fJson.AddPad(i + 1, padnames[i], fCanvas->GetPad(i + 1));
+    Int_t nwritten = fJson.EndPage();
+    if( fVerbosity >= 1 )
+      cout << "JSON: " << nwritten << " pads of page " << current_page + 1
+           << " written, seq " << fJson.GetSeq() << endl;
+  }
+  if( fVerbosity >= 2 ) {
+    if( const auto* pm = fMemory.GetPage(current_page) )
+      fMemory.Print(cout, *pm);
+  }
+  if( fIOStats.IsEnabled() )
+    fIOStats.PrintPage(cout, current_page);
+  fManifest.Save();
 
-  if( fConfig.IsMonitor() ) {
+  if( fConfig.IsMonitor() && !fPrintOnly ) {
     char buffer[9]; // HH:MM:SS
     time_t t = time(nullptr);
     TString sLastUpdated("Plots updated at: ");
@@ -486,6 +715,18 @@ void OnlineGUI::DoDraw()
     CheckPageButtons();
   }
 
+  StartupTimer::Instance().Mark("draw first page");
+  StartupTimer::Instance().Report(cout);
+}
+
+void OnlineGUI::DrawPage( Int_t page )
+{
+  // Draw the given page (0-based). In batch mode, the page is drawn on the
+  // batch canvas, e.g. for benchmarking.
+  if( fPrintOnly )
+    fCanvas = GetPrintCanvas();
+  current_page = page;
+  DoDraw();
 }
 
 void OnlineGUI::DrawNext()
@@ -559,6 +800,24 @@ void OnlineGUI::GetFileObjects()
   // Utility to find all objects within a File (TTree, TH1F, etc).
   //  The pair stored in the vector is <ObjName, ObjType>
   //  If there's no good keys.. do nothing.
+  Profiler::Span span(fProfiler, "GetFileObjects");
+  if( fMapFile ) {
+    // The records of a map file hold addresses in the producer's mapping
+    // of the shared memory; OrgAddress() converts one of ours to theirs
+    fileObjects.clear();
+    fMapFile->AcquireSemaphore();
+    TMapRec* mr = fMapFile->GetFirst();
+    Long_t offset = (Long_t) mr - (Long_t) fMapFile->OrgAddress(mr);
+    while( fMapFile->OrgAddress(mr) ) {
+      fileObjects.emplace_back(mr->GetName(offset), mr->GetClassName(offset));
+      mr = mr->GetNext(offset);
+    }
+    fMapFile->ReleaseSemaphore();
+    if( fVerbosity >= 1 )
+      cout << "Map file objects = " << fileObjects.size() << endl;
+    fUpdate = !fileObjects.empty();
+    return;
+  }
   if( fVerbosity >= 1 )
     cout << "Keys = " << fRootFile->ReadKeys() << endl;
 
@@ -593,6 +852,7 @@ void OnlineGUI::GetTreeVars()
 {
   // Utility to find all variables (leaves/branches) within a
   // Specified TTree and put them within the treeVars vector.
+  Profiler::Span span(fProfiler, "GetTreeVars");
   treeVars.clear();
   TObjArray* branchList;
   vector<TString> currentTree;
@@ -622,11 +882,36 @@ void OnlineGUI::GetTreeVars()
 }
 
 
+//_____________________________________________________________________________
+// Chain tree 'name' over 'segments'. The segments chained in 'old', the
+// chain of the same run at the previous update, except its last, growing,
+// one, are added with their known number of entries, so that their files
+// are not opened again just to count them.
+static TChain* ChainSegments( const TString& name, const VecStr_t& segments,
+                              TChain* old )
+{
+  auto* chain = new TChain(name);
+  Int_t nknown = 0;
+  if( old && old->GetEntries() >= 0 )
+    nknown = min(old->GetNtrees(), Int_t(segments.size())) - 1;
+  const Long64_t* offset = nknown > 0 ? old->GetTreeOffset() : nullptr;
+  for( Int_t k = 0; k < SINT(segments.size()); ++k ) {
+    if( k < nknown && offset[k + 1] > offset[k] )
+      chain->Add(segments[k].c_str(), offset[k + 1] - offset[k]);
+    else
+      chain->Add(segments[k].c_str());
+  }
+  return chain;
+}
+
+//_____________________________________________________________________________
 void OnlineGUI::GetRootTree()
 {
   // Utility to search a ROOT File for ROOT Trees
   // Fills the fRootTree vector
+  Profiler::Span span(fProfiler, "GetRootTree");
   fRootTree.clear();
+  treeVars.clear();  // Rebuilt when needed, see GetTreeIndex
 
   std::list<TString> found;
   for( const auto& fileObject: fileObjects ) {
@@ -643,10 +928,24 @@ void OnlineGUI::GetRootTree()
   found.unique();
   UInt_t nTrees = found.size();
 
+  // Chain the trees over all segments of the run. The chains of the
+  // previous update give the entries of the completed segments.
+  vector<unique_ptr<TChain>> chains;
   for( UInt_t i = 0; i < nTrees; i++ ) {
-    fRootTree.push_back((TTree*) fRootFile->Get(found.front()));
+    if( fConfig.IsMultiSegment() ) {
+      TChain* old = nullptr;
+      for( const auto& c: fChains ) {
+        if( found.front() == c->GetName() )
+          old = c.get();
+      }
+      chains.emplace_back(ChainSegments(found.front(),
+                                        fConfig.GetRootSegments(), old));
+      fRootTree.push_back(chains.back().get());
+    } else
+      fRootTree.push_back((TTree*) fRootFile->Get(found.front()));
     found.pop_front();
   }
+  fChains = std::move(chains);
   // Initialize the fTreeEntries vector
   fTreeEntries.clear();
   for( UInt_t i = 0; i < fRootTree.size(); i++ ) {
@@ -663,6 +962,11 @@ UInt_t OnlineGUI::GetTreeIndex( const TString& var )
   // Returns the correct index.  if not found returns an index 1
   // larger than fRootTree.size()
 
+  // The variable lists are built on first use, since a full scan of the
+  // branches of large trees slows down startup
+  if( treeVars.size() != fRootTree.size() )
+    GetTreeVars();
+
   //  This is for 2d draws... look for the first only
   string svar{var.Data()};
   auto pos = svar.find_first_of(":-/*+([");
@@ -700,6 +1004,37 @@ UInt_t OnlineGUI::GetTreeIndexFromName( const TString& name )
   return fRootTree.size() + 1;
 }
 
+//_____________________________________________________________________________
+// Get histogram 'name' from 'file' via 'cache'. Reference files never change,
+// so each histogram is read only once and kept in memory, detached from the
+// file. Misses are cached as well.
+static TH1* GetCachedHist( TFile* file,
+                           map<string, unique_ptr<TH1>>& cache,
+                           const string& name, int verbosity )
+{
+  if( !file )
+    return nullptr;
+  auto it = cache.find(name);
+  if( it != cache.end() )
+    return it->second.get();
+
+  TH1* hist = nullptr;
+  file->GetObject(name.c_str(), hist);
+  if( hist )
+    hist->SetDirectory(nullptr);
+  else if( verbosity >= 1 )
+    cout << "Reference histogram " << name << " not found in "
+         << file->GetName() << endl;
+  cache[name].reset(hist);
+  return hist;
+}
+
+TH1* OnlineGUI::GetGoldenHist( const string& name )
+{
+  // Return the golden histogram with the given name, or nullptr if not found.
+  return GetCachedHist(fGoldenFile, fGoldenCache, name, fVerbosity);
+}
+
 void OnlineGUI::MacroDraw( const cmdmap_t& command )
 {
   // Called by DoDraw(), this will make a call to the defined macro, and
@@ -771,10 +1106,22 @@ void OnlineGUI::TimerUpdate()
   if( fVerbosity >= 1 )
     cout << __PRETTY_FUNCTION__ << "\t" << __LINE__ << endl;
 
+  if( fMapFile ) {
+    // The producer updates the histograms in place; only look for new ones
+    GetFileObjects();
+    if( fUpdate ) {
+      UpdateAlarms();
+      DoDraw();
+    }
+    timer->Reset();
+    return;
+  }
+
 #ifdef OLDTIMERUPDATE
   if( fVerbosity >= 2 )
     cout << "\t rtFile: " << fRootFile << "\t" << fConfig.GetRootFile() << endl;
   if( fRootFile ) {
+    KeepPadHists();
     fRootFile->Close();
     fRootFile->Delete();
     delete fRootFile;
@@ -801,17 +1148,23 @@ void OnlineGUI::TimerUpdate()
     hframe->Layout();
   }
 
+  // Pick up new segments of a multi-segment run
+  OpenSegments(kTRUE);
+
   // Open the Root Trees.  Give a warning if it's not there.
   GetFileObjects();
   if( fUpdate ) { // Only do this stuff if there are valid keys
     GetRootTree();
-    GetTreeVars();
     for( UInt_t i = 0; i < fRootTree.size(); i++ ) {
       if( !fRootTree[i] ) {
         fRootTree.erase(fRootTree.begin() + i);
       }
     }
+    UpdateStripCharts();
+    UpdateAlarms();
+    fOnlyChanged = kTRUE;
     DoDraw();
+    fOnlyChanged = kFALSE;
   }
   timer->Reset();
 
@@ -831,7 +1184,10 @@ void OnlineGUI::TimerUpdate()
   for(UInt_t i=0; i<fRootTree.size(); i++) {
     fRootTree[i]->Refresh();
   }
+  UpdateAlarms();
+  fOnlyChanged = kTRUE;
   DoDraw();
+  fOnlyChanged = kFALSE;
   timer->Reset();
 
 #endif
@@ -853,7 +1209,8 @@ void OnlineGUI::BadDraw( const TString& errMessage )
 {
   // Routine to display (in Pad) why a particular draw method has
   // failed.
-  auto* pt = new TPaveText(0.1, 0.1, 0.9, 0.9, "brNDC");
+  auto* pt = fArena.Adopt(current_page, current_pad,
+                          new TPaveText(0.1, 0.1, 0.9, 0.9, "brNDC"));
   pt->SetBorderSize(3);
   pt->SetFillColor(10);
   pt->SetTextAlign(22);
@@ -890,65 +1247,329 @@ void OnlineGUI::CheckRootFile()
   }
 }
 
-Int_t OnlineGUI::PrepareRootFiles()
+//_____________________________________________________________________________
+// Open 'filename' for reading in a background thread or, unless 'parallel',
+// in the calling thread when the result is asked for
+static future<TFile*> OpenInBackground( Profiler& prof, const string& filename,
+                                        bool parallel )
+{
+  auto policy = parallel ? launch::async : launch::deferred;
+  return async(policy, [&prof, filename]() {
+    Profiler::Span span(prof, "open", -1, -1, filename.c_str());
+    return new TFile(filename.c_str(), "READ");
+  });
+}
+
+//_____________________________________________________________________________
+Int_t OnlineGUI::GetUpdateInterval() const
+{
+  // Watchfile update interval in ms
+
+  Int_t interval = fConfig.GetUpdateInterval();
+  if( interval <= 0 )
+    interval = fMapFile ? MAPUPDATETIME : UPDATETIME;
+  return interval;
+}
+
+//_____________________________________________________________________________
+Bool_t OnlineGUI::ParallelOpen()
+{
+  // Whether to open files in background threads. This needs ROOT's thread
+  // safety, whose global locks slow down every later draw and read of the
+  // process. It pays off only in batch mode, where many files are opened
+  // (segments, multi-run jobs, the daemon); the GUI opens files in turn.
+
+  if( !fPrintOnly )
+    return kFALSE;
+  static bool enabled = false;
+  if( !enabled ) {
+    StartupTimer::Instance().Mark("initialize");
+    ROOT::EnableThreadSafety();
+    StartupTimer::Instance().Mark("enable thread safety");
+    enabled = true;
+  }
+  return kTRUE;
+}
+
+Int_t OnlineGUI::PrepareRootFiles( Bool_t openGolden )
 {
   // Open the RootFile. Die if it doesn't exist unless we're watching a file.
   // Also open GoldenFile. Warn if it doesn't exist.
-
+  // With openGolden = kFALSE, the golden files and their caches are kept,
+  // e.g. when moving on to the next run of a multi-run job.
+  // In batch mode, the golden files are opened in parallel with the
+  // RootFile (see ParallelOpen). The list of
+  // variables of each tree is built when first needed (GetTreeIndex).
+
+  Profiler::Span span(fProfiler, "PrepareRootFiles");
+  fChains.clear();
+  fSegmentFiles.clear();
+  fSegmentHists.clear();
+  fSegmentDraws.clear();
+  fSegmentRun.clear();
+  fDrawnPage = -1;
   delete fRootFile; fRootFile = nullptr;
-  delete fGoldenFile; fGoldenFile = nullptr;
-
-  fRootFile = new TFile(fConfig.GetRootFile(), "READ");
-  if( !fRootFile->IsOpen() ) {
-    ostringstream ostr;
-    ostr << "ERROR:  rootfile: " << fConfig.GetRootFile()
-         << " cannot be opened";
-    fFileAlive = kFALSE;
-    if( !fPrintOnly && fConfig.IsMonitor() ) {
-      cout << ostr.str() << endl;
-      cout << "Will wait... hopefully.." << endl;
-    } else {
-      cerr << ostr.str() << endl;
-      delete fRootFile;
-      fRootFile = nullptr;
-      return 1;
+  delete fMapFile; fMapFile = nullptr;
+  future<TFile*> golden, goldentree;
+  const string goldenfilename = fConfig.GetGoldenFile();
+  const string& goldentreefile = fConfig.GetGoldenTreeFile();
+  if( openGolden ) {
+    fGoldenCache.clear();
+    delete fGoldenFile; fGoldenFile = nullptr;
+    fGoldenTreeCache.clear();
+    delete fGoldenTreeFile; fGoldenTreeFile = nullptr;
+    doGolden = kFALSE;
+    if( fConfig.DoMakeGoldenTrees() ) {
+      openGolden = kFALSE;
+    } else if( !goldenfilename.empty() || !goldentreefile.empty() ) {
+      bool parallel = ParallelOpen();
+      if( !goldenfilename.empty() )
+        golden = OpenInBackground(fProfiler, goldenfilename, parallel);
+      if( !goldentreefile.empty() )
+        goldentree = OpenInBackground(fProfiler, goldentreefile, parallel);
     }
+  }
+
+  Int_t ret = 0;
+  if( !fConfig.GetMapFile().empty() ) {
+    ret = OpenMapFile();
   } else {
-    fFileAlive = kTRUE;
-    runNumber = fConfig.GetRunNumber();
-    // Open the Root Trees.  Give a warning if it's not there..
-    GetFileObjects();
-    GetRootTree();
-    GetTreeVars();
-    for( UInt_t i = 0; i < fRootTree.size(); i++ ) {
-      if( fRootTree[i] == nullptr ) {
-        fRootTree.erase(fRootTree.begin() + i);
+    {
+      Profiler::Span openspan(fProfiler, "open", -1, -1, fConfig.GetRootFile());
+      fRootFile = new TFile(fConfig.GetRootFile(), "READ");
+    }
+    StartupTimer::Instance().Mark("open ROOT file");
+    if( !fRootFile->IsOpen() ) {
+      ostringstream ostr;
+      ostr << "ERROR:  rootfile: " << fConfig.GetRootFile()
+           << " cannot be opened";
+      fFileAlive = kFALSE;
+      if( !fPrintOnly && fConfig.IsMonitor() ) {
+        cout << ostr.str() << endl;
+        cout << "Will wait... hopefully.." << endl;
+      } else {
+        cerr << ostr.str() << endl;
+        delete fRootFile;
+        fRootFile = nullptr;
+        ret = 1;
       }
+    } else {
+      fFileAlive = kTRUE;
+      runNumber = fConfig.GetRunNumber();
+      OpenSegments(kFALSE);
+      if( !fConfig.GetSnapshotFile().empty() && !fConfig.IsMonitor() )
+        OpenSnapshot();
+      // Open the Root Trees.  Give a warning if it's not there..
+      GetFileObjects();
+      GetRootTree();
+      for( UInt_t i = 0; i < fRootTree.size(); i++ ) {
+        if( fRootTree[i] == nullptr ) {
+          fRootTree.erase(fRootTree.begin() + i);
+        }
+      }
+      StartupTimer::Instance().Mark("scan ROOT file");
     }
   }
-  TString goldenfilename = fConfig.GetGoldenFile();
-  if( !goldenfilename.IsNull() ) {
-    fGoldenFile = new TFile(goldenfilename, "READ");
+  if( !openGolden )
+    return ret;
+
+  if( golden.valid() ) {
+    fGoldenFile = golden.get();
     doGolden = fGoldenFile->IsOpen();
     if( !doGolden ) {
       cerr << "ERROR: goldenrootfile: " << goldenfilename
            << " cannot be opened.  Oh well, no comparison plots." << endl;
       delete fGoldenFile;
       fGoldenFile = nullptr;
-      if( fFileAlive )
-        fRootFile->cd();
     }
-  } else {
-    doGolden = kFALSE;
-    fGoldenFile = nullptr;
   }
+  if( goldentree.valid() ) {
+    fGoldenTreeFile = goldentree.get();
+    if( !fGoldenTreeFile->IsOpen() ) {
+      cerr << "ERROR: goldentreefile: " << goldentreefile
+           << " cannot be opened.  No comparison plots for tree variables."
+           << endl;
+      delete fGoldenTreeFile;
+      fGoldenTreeFile = nullptr;
+    }
+  }
+  StartupTimer::Instance().Mark("wait for golden files");
+  if( fFileAlive && fRootFile )
+    fRootFile->cd();
 
-  return 0;
+  return ret;
+}
+
+string OnlineGUI::GetInputIdentity() const
+{
+  // Name, size, modification time and UUID of each input file of the run.
+  // Changes whenever any of the files is replaced or modified.
+  ostringstream ostr;
+  auto add = [&ostr]( const TFile* file ) {
+    if( !file || !file->IsOpen() )
+      return;
+    FileStat_t fs;
+    Long_t mtime = 0;
+    if( gSystem->GetPathInfo(file->GetName(), fs) == 0 )
+      mtime = fs.fMtime;
+    ostr << file->GetName() << ":" << file->GetSize() << ":" << mtime << ":"
+         << file->GetUUID().AsString() << ";";
+  };
+  add(fRootFile);
+  for( const auto& seg: fSegmentFiles )
+    add(seg.get());
+  return ostr.str();
+}
+
+void OnlineGUI::OpenSnapshot()
+{
+  // Open the histogram snapshot of the current run. Its key combines the
+  // configuration digest and the identity of the input files; the pad
+  // identity selects the histogram. The snapshot is written in batch mode
+  // only, when closed at the end of PrintPages().
+
+  string filename = SubstitutePlaceholders(fConfig.GetSnapshotFile());
+  if( fPrintOnly && MakePlotsDir(DirnameStr(filename)) )
+    throw runtime_error("Bad directory name");
+  // Settings that change how tree variables are drawn
+  string key = "config=" + fConfig.GetConfigDigest() +
+               " scattermaxpoints=" +
+               to_string(fConfig.GetScatterMaxPoints()) +
+               " drawbuffer=" + to_string(fConfig.GetDrawBuffer()) +
+               " input=" + GetInputIdentity();
+  fSnapshot.Open(filename, key, fPrintOnly, fVerbosity);
+}
+
+void OnlineGUI::OpenSegments( Bool_t rescan )
+{
+  // Open the segments after the first of a multi-segment run, in parallel
+  // in batch mode.
+  // Segments already open are kept, except for the previously last one,
+  // which may have grown since. With 'rescan', look for new segments first.
+
+  if( rescan )
+    fConfig.FindSegments();
+  const VecStr_t& segments = fConfig.GetRootSegments();
+  // The run is identified by its first segment (fRootFile), by name and
+  // UUID. Nothing kept for another run applies.
+  string runid = fRootFile ? string(fRootFile->GetName()) + " " +
+                             fRootFile->GetUUID().AsString() : string();
+  if( runid != fSegmentRun ) {
+    fSegmentFiles.clear();
+    fSegmentHists.clear();
+    fSegmentDraws.clear();
+    fChains.clear();
+    fSegmentRun = runid;
+  }
+  size_t nkeep = 0;
+  if( !fSegmentFiles.empty() && segments.size() > 1 )
+    nkeep = min(fSegmentFiles.size() - 1, segments.size() - 2);
+  for( size_t i = 0; i < nkeep; ++i ) {
+    if( segments[i + 1] != fSegmentFiles[i]->GetName() ) {
+      // Different run. Nothing cached applies.
+      nkeep = 0;
+      fSegmentHists.clear();
+      fSegmentDraws.clear();
+      break;
+    }
+  }
+  fSegmentFiles.resize(nkeep);
+  if( segments.size() <= nkeep + 1 )
+    return;
+
+  bool parallel = ParallelOpen();
+  vector<future<TFile*>> opening;
+  for( size_t i = nkeep + 1; i < segments.size(); ++i )
+    opening.push_back(OpenInBackground(fProfiler, segments[i], parallel));
+  for( auto& f: opening ) {
+    fSegmentFiles.emplace_back(f.get());
+    if( !fSegmentFiles.back()->IsOpen() )
+      cerr << "ERROR: Cannot open segment " << fSegmentFiles.back()->GetName()
+           << endl;
+  }
+  if( fRootFile )
+    fRootFile->cd();
+}
+
+//_____________________________________________________________________________
+// Read histogram 'name' from 'file' and detach it. Safe to call for
+// different files in parallel.
+static TH1* ReadDetachedHist( TFile* file, const string& name )
+{
+  TH1* hist = nullptr;
+  if( file && file->IsOpen() )
+    file->GetObject(name.c_str(), hist);
+  if( hist )
+    hist->SetDirectory(nullptr);
+  return hist;
+}
+
+TH1* OnlineGUI::GetRunHist( const TString& name )
+{
+  // Return histogram 'name' of the current run. For a multi-segment run,
+  // this is the sum over all segments, owned by the current pad. The sum
+  // over completed segments is kept, so that in watchfile mode only the
+  // last segment is read again on update. In batch mode, segments are read
+  // in parallel.
+
+  if( fMapFile ) {
+    // A copy of the producer's current histogram
+    unique_ptr<TObject> obj(fMapFile->Get(name));
+    auto* hist = dynamic_cast<TH1*>(obj.get());
+    if( !hist )
+      return nullptr;
+    obj.release();
+    hist->SetDirectory(nullptr);
+    fArena.Adopt(current_page, current_pad, hist);
+    return hist;
+  }
+  if( fSegmentFiles.empty() )
+    return dynamic_cast<TH1*>(gDirectory->Get(name));
+
+  const string sname = name.Data();
+  size_t nseg = fSegmentFiles.size() + 1;
+  size_t ncomplete = fConfig.IsMonitor() ? nseg - 1 : nseg;
+  auto segfile = [this]( size_t i ) {
+    return i == 0 ? fRootFile : fSegmentFiles[i - 1].get();
+  };
+  SegmentSum& sum = fSegmentHists[sname];
+  if( sum.nseg < ncomplete ) {
+    auto policy = ParallelOpen() ? launch::async : launch::deferred;
+    vector<future<TH1*>> reading;
+    for( size_t i = sum.nseg; i < ncomplete; ++i )
+      reading.push_back(async(policy, ReadDetachedHist, segfile(i), sname));
+    for( auto& r: reading ) {
+      unique_ptr<TH1> hist(r.get());
+      if( !hist )
+        continue;
+      if( sum.hist )
+        sum.hist->Add(hist.get());
+      else
+        sum.hist = std::move(hist);
+    }
+    sum.nseg = ncomplete;
+  }
+
+  TH1* hist = sum.hist ? static_cast<TH1*>(sum.hist->Clone()) : nullptr;
+  if( ncomplete < nseg ) {
+    TH1* last = ReadDetachedHist(segfile(nseg - 1), sname);
+    if( hist && last ) {
+      hist->Add(last);
+      delete last;
+    } else if( last )
+      hist = last;
+  }
+  fArena.Adopt(current_page, current_pad, hist);
+  return hist;
 }
 
 Int_t OnlineGUI::OpenRootFile()
 {
-  fRootFile = new TFile(fConfig.GetRootFile(), "READ");
+  fDrawnPage = -1;
+  {
+    Profiler::Span span(fProfiler, "open", -1, -1, fConfig.GetRootFile());
+    fRootFile = new TFile(fConfig.GetRootFile(), "READ");
+  }
   if( fRootFile->IsZombie() || (fRootFile->GetSize() == -1)
       || (fRootFile->ReadKeys() == 0) ) {
     cout << "New run not yet available.  Waiting..." << endl;
@@ -974,7 +1595,6 @@ Int_t OnlineGUI::OpenRootFile()
   GetFileObjects();
   if( fUpdate ) { // Only do this stuff if there are valid keys
     GetRootTree();
-    GetTreeVars();
     for( UInt_t i = 0; i < fRootTree.size(); i++ ) {
       if( !fRootTree[i] ) {
         fRootTree.erase(fRootTree.begin() + i);
@@ -988,41 +1608,233 @@ Int_t OnlineGUI::OpenRootFile()
 
 }
 
-void OnlineGUI::SaveImage( TObject* o, const cmdmap_t& command ) const
+//_____________________________________________________________________________
+Int_t OnlineGUI::OpenMapFile()
 {
-  if( fSaveImages ) {
-    const string& var = getMapVal(command, "variable");
-    if( !var.empty() ) {
-      auto c = MakeCanvas();
-      SetupPad(command);
-      const char* opt = getMapVal(command, "drawopt").c_str();
-      o->Draw(opt);
-      auto outfile = SubstitutePlaceholders(fConfig.GetProtoImageFile(), var);
-      auto outdir = DirnameStr(outfile);
-      if( MakePlotsDir(outdir) == 0 )
-        c->SaveAs(outfile.c_str());
-    }
+  // Attach to the shared-memory map file (TMapFile) of a running producer.
+  // Its histograms are updated in place by the producer and read from
+  // memory on each update, without reopening any file.
+
+  const string& mapfile = fConfig.GetMapFile();
+  {
+    Profiler::Span span(fProfiler, "open", -1, -1, mapfile.c_str());
+    fMapFile = TMapFile::Create(mapfile.c_str());
   }
+  if( !fMapFile || fMapFile->IsZombie() ) {
+    cerr << "ERROR: map file " << mapfile << " cannot be opened. "
+         << "Is the producer running?" << endl;
+    delete fMapFile;
+    fMapFile = nullptr;
+    fFileAlive = kFALSE;
+    return 1;
+  }
+  fFileAlive = kTRUE;
+  runNumber = fConfig.GetRunNumber();
+  GetFileObjects();
+  StartupTimer::Instance().Mark("open map file");
+  return 0;
 }
 
-void OnlineGUI::SaveMacroImage( const cmdmap_t& drawcommand )
+void OnlineGUI::SaveImage( const cmdmap_t& command )
 {
-  if( fSaveImages ) {
-    auto c = MakeCanvas();
-    MacroDraw(drawcommand);
-    auto outfile = SubstitutePlaceholders(
-      fConfig.GetProtoMacroImageFile(), getMapVal(drawcommand, "macro"));
-    auto outdir = DirnameStr(outfile);
-    if( MakePlotsDir(outdir) == 0 )
-      c->SaveAs(outfile.c_str());
-    // Switch back to main canvas for subsequent MacroDraw call
-    fCanvas->cd(current_pad);
+  // Request an image of the current pad. It is written by SavePadImage()
+  // once the pad is complete.
+  if( !fSaveImages )
+    return;
+  const string& var = getMapVal(command, "variable");
+  if( var == "macro" )
+    fImageFile = SubstitutePlaceholders(fConfig.GetProtoMacroImageFile(),
+                                        getMapVal(command, "macro"));
+  else if( !var.empty() )
+    fImageFile = SubstitutePlaceholders(fConfig.GetProtoImageFile(), var);
+}
+
+//_____________________________________________________________________________
+// Let the primitives of 'pad', a copy made with Clone(), and of its sub-pads
+// be deleted with it. The originals are owned by the pad arena or the
+// display cache, so the copies do not have kCanDelete set.
+static void OwnPrimitives( TVirtualPad* pad )
+{
+  TIter next(pad->GetListOfPrimitives());
+  while( TObject* obj = next() ) {
+    obj->SetBit(TObject::kCanDelete);
+    if( auto* sub = dynamic_cast<TVirtualPad*>(obj) )
+      OwnPrimitives(sub);
   }
 }
 
-void OnlineGUI::HistDraw( const cmdmap_t& command )
+void OnlineGUI::SavePadImage( const cmdmap_t& command )
+{
+  // Write the image requested while drawing the current pad. A copy of the
+  // pad, with all its primitives, is drawn on a batch canvas of the size of
+  // the page canvas, so that nothing is drawn from the input or executed
+  // a second time.
+
+  if( fImageFile.empty() )
+    return;
+  string outfile;
+  swap(outfile, fImageFile);
+  TVirtualPad* pad = fCanvas->GetPad(current_pad);
+  if( !pad )
+    return;
+  // Nothing to do if the same pad contents were saved before with the same
+  // settings
+  string digest;
+  if( fManifest.IsEnabled() ) {
+    digest = OutputManifest::Digest(pad, PadSettings(command));
+    if( fManifest.IsUnchanged(outfile, digest) )
+      return;
+  }
+  auto c = fCanvasPool.Acquire(gPad->GetWw(), gPad->GetWh());
+  auto* copy = static_cast<TPad*>(pad->Clone());
+  copy->SetPad(0, 0, 1, 1);
+  copy->SetBit(TObject::kCanDelete);
+  OwnPrimitives(copy);
+  copy->Draw();
+  auto outdir = DirnameStr(outfile);
+  Profiler::Span span(fProfiler, "SaveAs", current_page, current_pad,
+                      outfile.c_str());
+  if( MakePlotsDir(outdir) == 0 ) {
+    c->SaveAs(outfile.c_str());
+    fManifest.Update(outfile, digest);
+  }
+  fCanvas->cd(current_pad);
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::UseDisplayCopy( TH1* hist, const cmdmap_t& command )
+{
+  // Paint a large histogram, just drawn in the current pad, through a copy
+  // rebinned to the pixel size of the pad, unless the pad is to be drawn at
+  // full resolution. The histogram itself is left as it is.
+
+  if( hist && command.find("fullres") == command.end() &&
+      fDisplay.Replace(gPad, current_page, hist) && fVerbosity >= 2 )
+    cout << "Drawing " << hist->GetName() << " through a display copy"
+         << endl;
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::DisplayZoomed()
+{
+  // Called when an axis range of a pad is changed or reset in the GUI, but
+  // also by the histogram painter while painting the pad. If the pad shows
+  // a display copy whose visible range changed, rebuild it for that range,
+  // so that zooming in gets back to the full resolution. The copy is being
+  // painted, so it is replaced only after the paint, from fZoomTimer.
+
+  auto* sender = static_cast<TQObject*>(gTQSender);
+  auto* pad = dynamic_cast<TVirtualPad*>(sender);
+  if( !pad || !fCanvas || !fZoomTimer ||
+      fCanvas->GetPad(pad->GetNumber()) != pad ||
+      !fDisplay.RangeChanged(pad, current_page) )
+    return;
+  fZoomPad = pad->GetNumber();
+  fZoomTimer->Start(0, kTRUE);
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::ApplyZoom()
+{
+  // Rebuild the display copy of the pad zoomed last (see DisplayZoomed)
+
+  TVirtualPad* pad = fCanvas ? fCanvas->GetPad(fZoomPad) : nullptr;
+  if( pad && fDisplay.Zoom(pad, current_page) )
+    pad->Update();
+}
+
+//_____________________________________________________________________________
+string OnlineGUI::GetPadInputs( const cmdmap_t& command )
+{
+  // Describe what the pad drawn by 'command' depends on: its definition and
+  // the state of its input, i.e. the key of a stored histogram (cycle, date
+  // and position in each file of the run) or the number of entries of a
+  // tree. If this does not change between watchfile updates, the pad is kept
+  // as it is. Returns an empty string if the input cannot be tracked, e.g.
+  // for macros, so that the pad is always redrawn.
+
+  const string& cmd = getMapVal(command, "variable");
+  if( cmd.empty() )
+    return "empty";
+  if( cmd == "macro" || cmd == "loadmacro" || cmd == "loadlib" ||
+      cmd == "trend" || cmd == "stripchart" || fMapFile || !fRootFile )
+    return {};
+
+  ostringstream ostr;
+  ostr << GetPadIdentity(command) << " " << PadSettings(command) << " ";
+  if( IsHistogram(cmd) ) {
+    string keys = GetHistKeyState(cmd);
+    if( keys.empty() )
+      return {};
+    ostr << keys;
+  } else {
+    const string& mtree = getMapVal(command, "tree");
+    UInt_t iTree = mtree.empty() ? GetTreeIndex(cmd)
+                                 : GetTreeIndexFromName(mtree);
+    if( iTree >= fRootTree.size() || !fRootTree[iTree] )
+      return {};
+    ostr << fRootFile->GetUUID().AsString() << " "
+         << fRootTree[iTree]->GetEntries();
+  }
+  return ostr.str();
+}
+
+//_____________________________________________________________________________
+string OnlineGUI::GetHistKeyState( const string& name )
+{
+  // The keys of stored histogram 'name' in the files of the current run:
+  // file identity, and cycle, date and position in each file. Empty if it is
+  // not found in all of them, or if the run is read from a map file.
+
+  if( fMapFile || !fRootFile )
+    return {};
+  ostringstream ostr;
+  ostr << fRootFile->GetUUID().AsString();
+  vector<TFile*> files{fRootFile};
+  for( const auto& seg: fSegmentFiles )
+    files.push_back(seg.get());
+  for( auto* file: files ) {
+    TKey* key = file->GetKey(name.c_str());
+    if( !key )
+      return {};
+    ostr << " " << key->GetCycle() << " " << key->GetDatime().Get()
+         << " " << key->GetSeekKey();
+  }
+  return ostr.str();
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::KeepPadHists()
+{
+  // Before the ROOT file is reopened on a watchfile update, take over the
+  // histograms of the current page that still belong to it, so that the
+  // pads that are not redrawn keep displaying them.
+
+  if( fDrawnPage != current_page || !fCanvas || !fRootFile )
+    return;
+  UInt_t draw_count = fConfig.GetDrawCount(current_page);
+  for( Int_t ipad = 1; ipad <= SINT(draw_count); ++ipad ) {
+    TVirtualPad* pad = fCanvas->GetPad(ipad);
+    if( !pad )
+      continue;
+    vector<TH1*> hists;
+    TIter next(pad->GetListOfPrimitives());
+    while( TObject* obj = next() ) {
+      if( obj->InheritsFrom("TH1") )
+        hists.push_back(static_cast<TH1*>(obj));
+    }
+    hists.push_back(fDisplay.GetFull(pad, current_page));
+    for( auto* hist: hists ) {
+      if( hist && hist->GetDirectory() == fRootFile )
+        fArena.Adopt(current_page, ipad, hist);
+    }
+  }
+}
+
+TH1* OnlineGUI::HistDraw( const cmdmap_t& command )
 {
   // Called by DoDraw(), this will plot a histogram.
+  // Returns the drawn histogram, if any.
 
   Bool_t showGolden = doGolden && command.find("noshowgolden") == command.end();
 
@@ -1033,21 +1845,20 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
 
   // Determine dimensionality of histogram
   const string& var = getMapVal(command, "variable");
-  if( var.empty() ) return;
+  if( var.empty() ) return nullptr;
   const char* cvar = var.c_str();
   for( const auto& fileObject: fileObjects ) {
     if( fileObject.first.Contains(var) ) {
       if( fileObject.second.Contains("TH1") ) {
-        if( showGolden ) fRootFile->cd();
-        mytemp1d = dynamic_cast<TH1*> (gDirectory->Get(cvar));
+        if( showGolden && fRootFile ) fRootFile->cd();
+        mytemp1d = GetRunHist(cvar);
         assert(mytemp1d);
         if( !mytemp1d ) break;
         if( mytemp1d->GetEntries() == 0 ) {
           BadDraw("Empty Histogram");
         } else {
           if( showGolden ) {
-            fGoldenFile->cd();
-            mytemp1d_golden = dynamic_cast<TH1*> (gDirectory->Get(cvar));
+            mytemp1d_golden = GetGoldenHist(var);
             assert(mytemp1d_golden);
             if( !mytemp1d_golden ) break;
             mytemp1d_golden->SetLineColor(30);
@@ -1064,14 +1875,16 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
             mytemp1d->SetStats(showstat);
             if( newtitle != "" ) mytemp1d->SetTitle(newtitle);
             mytemp1d->Draw(drawopt);
+            UseDisplayCopy(mytemp1d, command);
           }
-          SaveImage(mytemp1d, command);
+          SaveImage(command);
+          return mytemp1d;
         }
         break;
       }
       if( fileObject.second.Contains("TH2") ) {
-        if( showGolden ) fRootFile->cd();
-        mytemp2d = dynamic_cast<TH2*> (gDirectory->Get(cvar));
+        if( showGolden && fRootFile ) fRootFile->cd();
+        mytemp2d = dynamic_cast<TH2*> (GetRunHist(cvar));
         assert(mytemp2d);
         if( !mytemp2d ) break;
         if( mytemp2d->GetEntries() == 0 ) {
@@ -1093,13 +1906,15 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
           if( newtitle != "" ) mytemp2d->SetTitle(newtitle);
           mytemp2d->SetStats(showstat);
           mytemp2d->Draw(drawopt);
-          SaveImage(mytemp2d, command);
+          UseDisplayCopy(mytemp2d, command);
+          SaveImage(command);
+          return mytemp2d;
         }
         break;
       }
       if( fileObject.second.Contains("TH3") ) {
-        if( showGolden ) fRootFile->cd();
-        mytemp3d = dynamic_cast<TH3*> (gDirectory->Get(cvar));
+        if( showGolden && fRootFile ) fRootFile->cd();
+        mytemp3d = dynamic_cast<TH3*> (GetRunHist(cvar));
         assert(mytemp3d);
         if( !mytemp3d ) break;
         if( mytemp3d->GetEntries() == 0 ) {
@@ -1107,8 +1922,7 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
         } else {
           mytemp3d->Draw();
           if( showGolden ) {
-            fGoldenFile->cd();
-            mytemp3d_golden = dynamic_cast<TH3*> (gDirectory->Get(cvar));
+            mytemp3d_golden = dynamic_cast<TH3*> (GetGoldenHist(var));
             assert(mytemp3d_golden);
             if( !mytemp3d_golden ) break;
             mytemp3d_golden->SetMarkerColor(2);
@@ -1117,33 +1931,559 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
           } else {
             mytemp3d->Draw(drawopt);
           }
-          SaveImage(mytemp3d, command);
+          SaveImage(command);
+          return mytemp3d;
         }
         break;
       }
     }
   }
+  return nullptr;
 }
 
-void OnlineGUI::TreeDraw( const cmdmap_t& command )
+void OnlineGUI::TrendDraw( const cmdmap_t& command )
 {
-  // Called by DoDraw(), this will plot a Tree Variable
+  // Called by DoDraw(), this will plot a summary metric of another pad
+  // against run number, taken from the trend store.
 
-  const string& mvar = getMapVal(command, "variable");
-  TString var = mvar;
+  const string& pad = getMapVal(command, "trendpad");
+  const string& metric = getMapVal(command, "metric");
+  if( !fTrend.IsEnabled() ) {
+    BadDraw("No trend file");
+    return;
+  }
+  TGraph* graph = fTrend.MakeGraph(pad, metric);
+  if( !graph ) {
+    BadDraw(("No trend data for " + pad + " " + metric).c_str());
+    return;
+  }
+  fArena.Adopt(current_page, current_pad, graph);
+  SetupPad(command);
+  string title = getMapVal(command, "title");
+  if( title.empty() )
+    title = pad + " " + metric;
+  graph->SetTitle((title + ";Run;" + metric).c_str());
+  graph->SetMarkerStyle(20);
+  graph->SetMarkerSize(0.6);
+  string drawopt = getMapVal(command, "drawopt");
+  graph->Draw(drawopt.empty() ? "ALP" : drawopt.c_str());
+  SaveImage(command);
+}
 
-  //  Check to see if we're projecting to a specific histogram
-  TString histoname = var(TRegexp(">>.+(?"));
-  if( histoname.Length() > 0 ) {
-    histoname.Remove(0, 2);
-    Int_t bracketindex = histoname.First("(");
-    if( bracketindex > 0 ) histoname.Remove(bracketindex);
-    if( fVerbosity >= 3 )
-      cout << histoname << " " << var(TRegexp(">>.+(?")) << endl;
+//_____________________________________________________________________________
+void OnlineGUI::StripChartDraw( const cmdmap_t& command )
+{
+  // Called by DoDraw(), this will plot the per-update metric of a stripchart
+  // pad, recorded by UpdateStripCharts(), against time.
+
+  if( !fConfig.IsMonitor() ) {
+    BadDraw("Strip charts need watchfile");
+    return;
+  }
+  auto it = fStripCharts.find(make_pair(current_page, current_pad));
+  TGraph* graph = it != fStripCharts.end() ? it->second.MakeGraph() : nullptr;
+  if( !graph ) {
+    BadDraw("Waiting for updates");
+    return;
+  }
+  fArena.Adopt(current_page, current_pad, graph);
+  SetupPad(command);
+  const string& var = getMapVal(command, "stripvar");
+  string title = getMapVal(command, "title");
+  if( title.empty() )
+    title = var == "rate" ? "Entry rate" : "Mean of " + var;
+  string ytitle = var == "rate" ? "Rate (Hz)" : var;
+  graph->SetTitle((title + ";Time;" + ytitle).c_str());
+  graph->SetMarkerStyle(20);
+  graph->SetMarkerSize(0.6);
+  TAxis* xaxis = graph->GetXaxis();
+  xaxis->SetTimeDisplay(1);
+  xaxis->SetTimeFormat("%H:%M:%S");
+  xaxis->SetTimeOffset(0, "gmt");
+  string drawopt = getMapVal(command, "drawopt");
+  graph->Draw(drawopt.empty() ? "ALP" : drawopt.c_str());
+  SaveImage(command);
+}
+
+//_____________________________________________________________________________
+Long64_t OnlineGUI::BoundedTreeDraw( TTree* tree, const TString& var,
+                                    const TCut& cut, const string& opt )
+{
+  // Draw 'var' from 'tree' into "htemp", like TTree::Draw, with bounded
+  // memory. TTree::Draw of a 2D or 3D histogram or profile without a given
+  // binning buffers the values of up to the tree's estimate of entries to
+  // find the axis ranges, and takes them from the first entries only if
+  // there are more. If there are more entries than --draw-buffer, the
+  // ranges are found in a separate pass instead, and "htemp" is booked with
+  // the limits TTree::Draw would give it and filled in chunks of
+  // --draw-buffer entries. Graph-style draws (no histogram or profile
+  // option) keep a point per entry; their estimate is capped at
+  // --draw-buffer, so that at most that many values per expression are
+  // buffered, and their axes are those of the first --draw-buffer entries.
+  // Smaller draws get an estimate large enough for all their entries.
+
+  Long64_t buffer = fConfig.GetDrawBuffer();
+  Long64_t nentries = tree->GetEntries();
+  vector<TString> dims = SplitDimensions(var);
+  Int_t ndim = static_cast<Int_t>(dims.size());
+  Long64_t estimate = tree->GetEstimate();
+  if( buffer <= 0 || ndim < 2 || ndim > 3 || var.Contains(">>") )
+    return tree->Draw(var, cut, opt.c_str());
+
+  Long64_t ndrawn;
+  TString lopt = opt.c_str();
+  lopt.ToLower();
+  const bool profile = lopt.Contains("prof");
+  if( nentries > buffer && !profile && !IsHistOption(opt) ) {
+    if( fVerbosity >= 1 )
+      cout << "Graph draw of " << var << ": buffering the values of "
+           << buffer << " of " << nentries << " entries" << endl;
+    tree->SetEstimate(buffer);
+    ndrawn = tree->Draw(var, cut, opt.c_str());
+    tree->SetEstimate(estimate);
+    return ndrawn;
+  }
+  if( nentries <= buffer ) {
+    if( estimate < nentries )
+      tree->SetEstimate(nentries);
+    ndrawn = tree->Draw(var, cut, opt.c_str());
+    tree->SetEstimate(estimate);
+    return ndrawn;
+  }
+
+  vector<Double_t> vmin, vmax;
+  Long64_t nfound = ScanRanges(tree, var, cut, ndim, buffer, vmin, vmax);
+  if( nfound <= 0 ) {
+    tree->SetEstimate(estimate);
+    return nfound < 0 ? nfound : tree->Draw(var, cut, opt.c_str());
+  }
+  TString title = var;
+  if( !TString(cut.GetTitle()).IsNull() )
+    title += Form(" {%s}", cut.GetTitle());
+  TH1* hist;
+  if( profile ) {
+    // Error option of the profile, as TTree::Draw takes it from "prof<x>"
+    Ssiz_t at = lopt.Index("prof") + 4;
+    TString perr;
+    if( at < lopt.Length() && TString("sig").Contains(lopt[at]) )
+      perr = lopt[at];
+    if( ndim == 2 ) {
+      hist = new TProfile("htemp", title,
+                          gEnv->GetValue("Hist.Binning.2D.Prof", 100),
+                          vmin[0], vmax[0], perr.Data());
+      THLimitsFinder::GetLimitsFinder()->FindGoodLimits(hist, vmin[0],
+                                                        vmax[0]);
+    } else {
+      hist = new TProfile2D("htemp", title,
+                            gEnv->GetValue("Hist.Binning.3D.Profx", 20),
+                            vmin[0], vmax[0],
+                            gEnv->GetValue("Hist.Binning.3D.Profy", 20),
+                            vmin[1], vmax[1], perr.Data());
+      THLimitsFinder::GetLimitsFinder()->FindGoodLimits(hist, vmin[0], vmax[0],
+                                                        vmin[1], vmax[1]);
+    }
+  } else if( ndim == 2 ) {
+    hist = new TH2F("htemp", title,
+                    gEnv->GetValue("Hist.Binning.2D.x", 40), vmin[0], vmax[0],
+                    gEnv->GetValue("Hist.Binning.2D.y", 40), vmin[1], vmax[1]);
+    THLimitsFinder::GetLimitsFinder()->FindGoodLimits(hist, vmin[0], vmax[0],
+                                                      vmin[1], vmax[1]);
   } else {
-    histoname = "htemp";
+    hist = new TH3F("htemp", title,
+                    gEnv->GetValue("Hist.Binning.3D.x", 20), vmin[0], vmax[0],
+                    gEnv->GetValue("Hist.Binning.3D.y", 20), vmin[1], vmax[1],
+                    gEnv->GetValue("Hist.Binning.3D.z", 20), vmin[2], vmax[2]);
+    THLimitsFinder::GetLimitsFinder()->FindGoodLimits(hist, vmin[0], vmax[0],
+                                                      vmin[1], vmax[1],
+                                                      vmin[2], vmax[2]);
+  }
+  hist->GetXaxis()->SetTitle(dims[ndim - 1]);
+  hist->GetYaxis()->SetTitle(dims[ndim - 2]);
+  if( ndim == 3 && !profile )
+    hist->GetZaxis()->SetTitle(dims[0]);
+  if( fVerbosity >= 1 )
+    cout << "Bounded draw of " << var << ": " << nfound << " values from "
+         << nentries << " entries" << endl;
+
+  // TTree::Draw fills an existing histogram a buffer at a time
+  tree->SetEstimate(buffer);
+  ndrawn = tree->Draw(var + ">>htemp", cut, opt.c_str());
+  tree->SetEstimate(estimate);
+  if( ndrawn < 0 )
+    delete hist;
+  return ndrawn;
+}
+
+//_____________________________________________________________________________
+TString OnlineGUI::ScatterMode( const cmdmap_t& command, TTree* tree,
+                                const TString& var, string& opt, TCut& cut )
+{
+  // Choose how to draw a scatter plot of 'var' from 'tree'. If more than
+  // --scatter-max-points entries are to be read, the plot is drawn as a
+  // density map, i.e. a fine 2D histogram drawn with "colz", or, with
+  // "-scatter sample", from every k-th entry only. The draw option or the
+  // cut are changed accordingly. Returns the text of the indicator to put
+  // on the pad, or an empty string for a plain scatter plot.
+
+  Long64_t maxpoints = fConfig.GetScatterMaxPoints();
+  const string& mode = getMapVal(command, "scatter");
+  if( maxpoints <= 0 || mode == "all" || !IsScatter(var, opt) )
+    return "";
+  Long64_t nentries = tree->GetEntries();
+  if( nentries <= maxpoints )
+    return "";
+  if( mode == "sample" ) {
+    Long64_t k = (nentries + maxpoints - 1) / maxpoints;
+    cut = cut && TCut(Form("Entry$%%%lld==0", k));
+    return Form("1 in %lld entries", k);
+  }
+  opt = "colz";
+  return Form("Density of %lld entries", nentries);
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::DrawScatterNote( const TString& note )
+{
+  // Mark a scatter plot drawn in density or sampling mode
+
+  if( note.IsNull() )
+    return;
+  auto* text = fArena.Adopt(current_page, current_pad,
+                            new TLatex(0.99, 0.01, note));
+  text->SetNDC();
+  text->SetTextAlign(31);
+  text->SetTextSize(0.04);
+  text->SetTextColor(kGray + 2);
+  text->Draw();
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::UpdateStripCharts()
+{
+  // Add a point to each stripchart pad of the configuration, computed from
+  // the tree entries added since the previous update only: the entry rate
+  // (of entries passing the cut, if any) or the mean of a variable. Called
+  // on every update in watchfile mode, for all pages, so that the charts of
+  // pages not shown keep filling. The first update, and the first after the
+  // number of entries went down (a new run), only set the starting point.
+
+  const double now = chrono::duration<double>(
+    chrono::system_clock::now().time_since_epoch()).count();
+  cmdmap_t command;
+  for( UInt_t page = 0; page < fConfig.GetPageCount(); page++ ) {
+    UInt_t draw_count = fConfig.GetDrawCount(page);
+    for( UInt_t j = 0; j < draw_count; j++ ) {
+      fConfig.GetDrawCommand(page, j, command);
+      if( getMapVal(command, "variable") != "stripchart" )
+        continue;
+      const string& var = getMapVal(command, "stripvar");
+      const string& snpoints = getMapVal(command, "npoints");
+      size_t npoints = snpoints.empty() ? 100 : stoul(snpoints);
+      auto key = make_pair(SINT(page), SINT(j) + 1);
+      auto it = fStripCharts.find(key);
+      if( it == fStripCharts.end() || it->second.Capacity() != npoints ) {
+        fStripCharts.erase(key);
+        it = fStripCharts.emplace(key, StripChart(npoints)).first;
+      }
+      StripChart& sc = it->second;
+
+      const string& mtree = getMapVal(command, "tree");
+      UInt_t iTree;
+      if( !mtree.empty() )
+        iTree = GetTreeIndexFromName(mtree);
+      else if( var == "rate" )
+        iTree = 0;
+      else
+        iTree = GetTreeIndex(var);
+      if( iTree >= fRootTree.size() )
+        continue;
+      TTree* tree = fRootTree[iTree];
+      Long64_t nentries = tree->GetEntries();
+      if( sc.fLastEntries < 0 || nentries < sc.fLastEntries ) {
+        sc.fLastEntries = nentries;
+        sc.fLastTime = now;
+        continue;
+      }
+      Long64_t first = sc.fLastEntries, nnew = nentries - first;
+      double dt = now - sc.fLastTime;
+      TCut cut = GetDrawCut(command);
+      bool ok = false;
+      double value = 0;
+      if( var == "rate" ) {
+        Long64_t nsel = nnew;
+        if( nnew > 0 && !TString(cut.GetTitle()).IsNull() )
+          nsel = tree->Draw("Entry$", cut, "goff", nnew, first);
+        ok = dt > 0 && nsel >= 0;
+        if( ok )
+          value = nsel / dt;
+      } else if( nnew > 0 ) {
+        const char* hname = "hstrip_tmp";
+        Long64_t nsel = tree->Draw(TString(var) + ">>" + hname, cut, "goff", nnew,
+                                   first);
+        unique_ptr<TH1> hist(dynamic_cast<TH1*>(gDirectory->FindObject(hname)));
+        if( hist ) {
+          hist->SetDirectory(nullptr);
+          ok = nsel > 0;
+          value = hist->GetMean();
+        }
+      }
+      if( ok )
+        sc.Push(now, value);
+      sc.fLastEntries = nentries;
+      sc.fLastTime = now;
+      if( fVerbosity >= 2 )
+        cout << "Strip chart page " << page + 1 << " pad " << j + 1 << ": "
+             << nnew << " new entries, " << var << " = " << value << endl;
+    }
+  }
+}
+
+//_____________________________________________________________________________
+// Read stored histogram 'name' from 'file' through its key, as a new object
+// detached from the file. Unlike TDirectory::Get, this never returns the
+// copy in memory that may be drawn in a pad.
+static TH1* ReadKeyHist( TFile* file, const string& name )
+{
+  TKey* key = file ? file->GetKey(name.c_str()) : nullptr;
+  TObject* obj = key ? key->ReadObj() : nullptr;
+  auto* hist = dynamic_cast<TH1*>(obj);
+  if( hist )
+    hist->SetDirectory(nullptr);
+  else
+    delete obj;
+  return hist;
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::UpdateAlarms()
+{
+  // Evaluate the checks of all pads of the configuration (-check pad
+  // option), for all pages, without drawing anything. Called on every update
+  // in watchfile mode. A stored histogram is read again only if its key in
+  // the file changed; tree pads only read the entries added since the
+  // previous update. Alarms raised and cleared are logged, and the pages
+  // with active alarms are marked in the page list.
+
+  Profiler::Span span(fProfiler, "alarms");
+  const double now = chrono::duration<double>(
+    chrono::system_clock::now().time_since_epoch()).count();
+  cmdmap_t command;
+  for( UInt_t page = 0; page < fConfig.GetPageCount(); page++ ) {
+    UInt_t draw_count = fConfig.GetDrawCount(page);
+    for( UInt_t j = 0; j < draw_count; j++ ) {
+      fConfig.GetDrawCommand(page, j, command);
+      auto key = make_pair(SINT(page), SINT(j) + 1);
+      const string& spec = getMapVal(command, "check");
+      if( spec.empty() ) {
+        fAlarms.erase(key);
+        continue;
+      }
+      const string& cmd = getMapVal(command, "variable");
+      PadAlarm& alarm = fAlarms[key];
+      if( alarm.spec != spec ) {
+        alarm = PadAlarm();
+        alarm.spec = spec;
+        string error;
+        if( !AlarmCheck::Parse(spec, alarm.checks, error) )
+          cerr << "ERROR: Page " << page + 1 << " pad " << j + 1 << ": "
+               << error << endl;
+        else if( cmd == "macro" || cmd == "loadmacro" || cmd == "loadlib" ||
+                 cmd == "trend" || cmd == "stripchart" ) {
+          cerr << "ERROR: Page " << page + 1 << " pad " << j + 1 << ": "
+               << "checks are not supported for " << cmd << " pads" << endl;
+          alarm.checks.clear();
+        }
+      }
+      if( alarm.checks.empty() )
+        continue;
+
+      Bool_t ok = IsHistogram(cmd) ? EvalHistAlarm(cmd, alarm, now)
+                                   : EvalTreeAlarm(command, alarm, now);
+      if( !ok )
+        continue;  // Input not available; keep the previous state
+      vector<string> active;
+      for( const auto& check: alarm.checks ) {
+        if( !check.Test(alarm.values).empty() )
+          active.push_back(check.GetSpec());
+      }
+      LogAlarms(key.first, key.second, cmd, alarm, active);
+      alarm.active = std::move(active);
+    }
+  }
+  ShowPageAlarms();
+}
+
+//_____________________________________________________________________________
+Bool_t OnlineGUI::EvalHistAlarm( const string& name, PadAlarm& alarm,
+                                 double now )
+{
+  // Quantities of stored histogram 'name' for the checks of its pad. The
+  // histogram is read only if it changed since the previous evaluation. For
+  // a multi-segment run, it is summed over all segments.
+
+  string source = GetHistKeyState(name);
+  if( source.empty() && !fMapFile )
+    return kFALSE;
+  if( fMapFile || source != alarm.source ) {
+    unique_ptr<TH1> hist;
+    if( fMapFile ) {
+      unique_ptr<TObject> obj(fMapFile->Get(name.c_str()));
+      if( dynamic_cast<TH1*>(obj.get()) )
+        hist.reset(static_cast<TH1*>(obj.release()));
+    } else {
+      hist.reset(ReadKeyHist(fRootFile, name));
+      for( const auto& seg: fSegmentFiles ) {
+        unique_ptr<TH1> seghist(ReadKeyHist(seg.get(), name));
+        if( hist && seghist )
+          hist->Add(seghist.get());
+      }
+    }
+    if( !hist )
+      return kFALSE;
+    hist->SetDirectory(nullptr);
+    AlarmValues& v = alarm.values;
+    v.entries = hist->GetEntries();
+    v.mean = hist->GetMean();
+    v.rms = hist->GetRMS();
+    v.ks = -1;
+    TH1* golden = doGolden ? GetGoldenHist(name) : nullptr;
+    if( golden && v.entries > 0 && golden->GetEntries() > 0 &&
+        golden->GetDimension() == hist->GetDimension() &&
+        golden->GetNcells() == hist->GetNcells() )
+      v.ks = hist->KolmogorovTest(golden);
+    alarm.source = source;
   }
+  alarm.SetEntries(alarm.values.entries, now, 1e-3 * GetUpdateInterval());
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+Bool_t OnlineGUI::EvalTreeAlarm( const cmdmap_t& command, PadAlarm& alarm,
+                                 double now )
+{
+  // Quantities of the tree draw of a pad for its checks, accumulated over
+  // the entries added to the tree since the previous evaluation. The mean
+  // and RMS are those of the variable of a one-dimensional draw; for other
+  // draws, only the number of selected entries and their rate are checked.
+  // There is no KS test for tree pads.
+
+  const string& var = getMapVal(command, "variable");
+  const string& mtree = getMapVal(command, "tree");
+  UInt_t iTree = mtree.empty() ? GetTreeIndex(var)
+                               : GetTreeIndexFromName(mtree);
+  if( iTree >= fRootTree.size() || !fRootTree[iTree] )
+    return kFALSE;
+  TTree* tree = fRootTree[iTree];
+  Long64_t nentries = tree->GetEntries();
+  string run = fRootFile ? fRootFile->GetUUID().AsString() : string();
+  if( nentries < alarm.treeEntries || run != alarm.source ) {
+    alarm.Reset();  // A new run
+    alarm.source = run;
+  }
+  // Drop the pad's own target histogram, if any
+  TString expr = var;
+  Ssiz_t target = expr.Index(">>");
+  if( target != kNPOS )
+    expr.Resize(target);
+  Long64_t first = max(alarm.treeEntries, Long64_t(0));
+  Long64_t nnew = nentries - first;
+  if( nnew > 0 ) {
+    TCut cut = GetDrawCut(command);
+    Long64_t nsel = nnew;
+    if( SplitDimensions(expr).size() == 1 ) {
+      const char* hname = "halarm_tmp";
+      nsel = tree->Draw(expr + ">>" + hname, cut, "goff", nnew, first);
+      unique_ptr<TH1> hist(dynamic_cast<TH1*>(gDirectory->FindObject(hname)));
+      if( hist ) {
+        hist->SetDirectory(nullptr);
+        Double_t stats[TH1::kNstat] = {};
+        hist->GetStats(stats);
+        alarm.sumw += stats[0];
+        alarm.sumwx += stats[2];
+        alarm.sumwx2 += stats[3];
+      }
+    } else if( !TString(cut.GetTitle()).IsNull() )
+      nsel = tree->Draw("Entry$", cut, "goff", nnew, first);
+    if( nsel < 0 ) {
+      // Error in the expression, which is not tried again
+      cerr << "ERROR: Cannot evaluate the checks of " << var << endl;
+      alarm.checks.clear();
+      return kFALSE;
+    }
+    alarm.selected += nsel;
+  }
+  alarm.treeEntries = nentries;
+  AlarmValues& v = alarm.values;
+  if( alarm.sumw > 0 ) {
+    v.mean = alarm.sumwx / alarm.sumw;
+    v.rms = sqrt(max(0., alarm.sumwx2 / alarm.sumw - v.mean * v.mean));
+  }
+  alarm.SetEntries(alarm.selected, now, 1e-3 * GetUpdateInterval());
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::LogAlarms( Int_t page, Int_t pad, const string& name,
+                           const PadAlarm& alarm, const vector<string>& active )
+{
+  // Log the checks of a pad that failed (active) and did not before, and
+  // those that failed before and no longer do
+
+  char buffer[20]; // YYYY-MM-DD HH:MM:SS
+  time_t t = time(nullptr);
+  strftime(buffer, 20, "%F %T", localtime(&t));
+  auto log = [&]( const string& what ) {
+    ostringstream ostr;
+    ostr << buffer << " run " << runNumber << " page " << page + 1
+         << " pad " << pad << " " << name << ": " << what;
+    cout << "Alarm: " << ostr.str() << endl;
+    fAlarmLog.Write(ostr.str());
+  };
+  for( const auto& check: alarm.checks ) {
+    const string& spec = check.GetSpec();
+    bool was = find(alarm.active.begin(), alarm.active.end(), spec)
+               != alarm.active.end();
+    bool is = find(active.begin(), active.end(), spec) != active.end();
+    if( is && !was )
+      log("ALARM " + check.Test(alarm.values) + " (" + spec + ")");
+    else if( was && !is )
+      log("cleared (" + spec + ")");
+  }
+}
 
+//_____________________________________________________________________________
+void OnlineGUI::ShowPageAlarms()
+{
+  // Mark the pages with active alarms in the page list, with their number
+  // of alarmed pads
+
+  UInt_t npages = fConfig.GetPageCount();
+  vector<Int_t> nalarms(npages, 0);
+  for( const auto& alarm: fAlarms ) {
+    if( !alarm.second.active.empty() && alarm.first.first < SINT(npages) )
+      ++nalarms[alarm.first.first];
+  }
+  if( !fPageListBox || nalarms == fPageAlarms )
+    return;
+  for( UInt_t page = 0; page < npages; page++ ) {
+    if( page < fPageAlarms.size() && nalarms[page] == fPageAlarms[page] )
+      continue;
+    auto* entry = dynamic_cast<TGTextLBEntry*>(
+      fPageListBox->GetEntry(SINT(page)));
+    if( !entry )
+      continue;
+    TString text = fConfig.GetPageTitle(page);
+    if( nalarms[page] > 0 )
+      text = Form("%s  [ALARM %d]", text.Data(), nalarms[page]);
+    entry->SetText(new TGString(text));
+    gClient->NeedRedraw(entry);
+  }
+  fPageListBox->Layout();
+  fPageAlarms = std::move(nalarms);
+}
+
+TCut OnlineGUI::GetDrawCut( const cmdmap_t& command )
+{
   // Combine the cuts (definecuts and specific cuts)
   TCut cut = "";
   const string& mcut = getMapVal(command, "cut");
@@ -1158,6 +2498,76 @@ void OnlineGUI::TreeDraw( const cmdmap_t& command )
     }
     cut = (TCut) tempCut;
   }
+  return cut;
+}
+
+TString OnlineGUI::GetPadIdentity( const cmdmap_t& command )
+{
+  //  Generate a "unique" identity of a tree-variable pad based on the MD5 of
+  //  the drawn variable, cut, drawopt, and plot title.
+  //  Makes it less likely to cause a name collision if two plot titles are the same.
+  //  If you draw the exact same plot twice, the histograms will have the same name, but
+  //  since they are exactly the same, you likely won't notice (or it will complain at you).
+  TString tmpstring = getMapVal(command, "variable");
+  tmpstring += GetDrawCut(command).GetTitle();
+  tmpstring += getMapVal(command, "drawopt");
+  tmpstring += getMapVal(command, "title");
+  return tmpstring.MD5();
+}
+
+void OnlineGUI::DrawGoldenTree( TH1* hist, const cmdmap_t& command )
+{
+  // Overlay the golden reference for a tree-variable pad, taken from the
+  // golden tree-draw file, onto 'hist' (which must be drawn in the current
+  // pad). Styling follows HistDraw. The reference is scaled to the same
+  // area as 'hist' since the runs are generally of different length.
+
+  if( !hist || hist->GetDimension() != 1 )
+    return;
+  TH1* golden = GetCachedHist(fGoldenTreeFile, fGoldenTreeCache,
+                              GetPadIdentity(command).Data(), fVerbosity);
+  if( !golden || golden->GetDimension() != 1 )
+    return;
+  double area = golden->Integral("width");
+  if( area > 0 )
+    golden->Scale(hist->Integral("width") / area);
+  golden->SetLineColor(30);
+  golden->SetFillColor(30);
+  Style_t fillstyle = fPrintOnly ? 3010 : 3027;
+  golden->SetFillStyle(fillstyle);
+  golden->SetStats(false);
+  golden->SetTitle(hist->GetTitle());
+
+  // Draw the reference first, then the current histogram on top of it
+  gPad->GetListOfPrimitives()->Remove(hist);
+  golden->Draw();
+  TString drawopt = getMapVal(command, "drawopt");
+  hist->Draw("sames" + drawopt);
+}
+
+TH1* OnlineGUI::TreeDraw( const cmdmap_t& command )
+{
+  // Called by DoDraw(), this will plot a Tree Variable.
+  // Returns the drawn histogram, if any.
+
+  const string& mvar = getMapVal(command, "variable");
+  TString var = mvar;
+
+  //  Check to see if we're projecting to a specific histogram
+  TString histoname = var(TRegexp(">>.+(?"));
+  if( histoname.Length() > 0 ) {
+    histoname.Remove(0, 2);
+    Int_t bracketindex = histoname.First("(");
+    if( bracketindex > 0 ) histoname.Remove(bracketindex);
+    if( fVerbosity >= 3 )
+      cout << histoname << " " << var(TRegexp(">>.+(?")) << endl;
+  } else {
+    histoname = "htemp";
+  }
+
+  // Combine the cuts (definecuts and specific cuts)
+  const string& mcut = getMapVal(command, "cut");
+  TCut cut = GetDrawCut(command);
 
   // Determine which Tree the variable comes from, then draw it.
   UInt_t iTree;
@@ -1172,11 +2582,31 @@ void OnlineGUI::TreeDraw( const cmdmap_t& command )
       cout << "got index from command " << iTree << endl;
   }
 
-  const string& mopt = getMapVal(command, "drawopt");
+  string mopt = getMapVal(command, "drawopt");
+  TString scatnote;
+  if( iTree < fRootTree.size() )
+    scatnote = ScatterMode(command, fRootTree[iTree], var, mopt, cut);
   if( mopt.find("colz") != string::npos )
     gPad->SetRightMargin(0.15);
   string mtitle = getMapVal(command, "title");
 
+  // Result of an identical draw of the same input, saved earlier
+  const TString padid = GetPadIdentity(command);
+  if( TH1* snap = fSnapshot.Get(padid.Data()) ) {
+    fArena.Adopt(current_page, current_pad, snap);
+    snap->Draw(mopt.c_str());
+    if( getMapVal(command, "grid") == "grid" )
+      gPad->SetGrid();
+    DrawScatterNote(scatnote);
+    if( fGoldenTreeFile && command.find("noshowgolden") == command.end() )
+      DrawGoldenTree(snap, command);
+    else
+      UseDisplayCopy(snap, command);
+    if( !mtitle.empty() )
+      SaveImage(command);
+    return snap;
+  }
+
   if( fVerbosity >= 3 )
     cout << "\tDraw option:" << mopt << " and histo name " << histoname << endl;
   if( iTree <= fRootTree.size() ) {
@@ -1191,33 +2621,68 @@ void OnlineGUI::TreeDraw( const cmdmap_t& command )
         cout << "\tProcessing from tree: " << iTree << "\t" << fRootTree[iTree]->GetTitle() << "\t"
              << fRootTree[iTree]->GetName() << endl;
     }
-    Long64_t nentries = fRootTree[iTree]->Draw(var, cut, mopt.c_str());
+    // Density maps are filled with a fine binning
+    Int_t binx = gEnv->GetValue("Hist.Binning.2D.x", 40);
+    Int_t biny = gEnv->GetValue("Hist.Binning.2D.y", 40);
+    if( !scatnote.IsNull() ) {
+      gEnv->SetValue("Hist.Binning.2D.x", max(binx, kDensityBins));
+      gEnv->SetValue("Hist.Binning.2D.y", max(biny, kDensityBins));
+    }
+    Long64_t nentries;
+    auto* chain = dynamic_cast<TChain*>(fRootTree[iTree]);
+    if( chain && fConfig.IsMonitor() && histoname == "htemp" &&
+        SplitDimensions(var).size() == 1 ) {
+      histoname = "hseg_" + padid;
+      nentries = SegmentTreeDraw(chain, var, cut, mopt, histoname);
+    } else {
+      fIOStats.Begin(fRootTree[iTree], current_page, current_pad, mvar);
+      if( histoname == "htemp" )
+        nentries = BoundedTreeDraw(fRootTree[iTree], var, cut, mopt);
+      else
+        nentries = fRootTree[iTree]->Draw(var, cut, mopt.c_str());
+      fIOStats.End();
+    }
+    if( !scatnote.IsNull() ) {
+      gEnv->SetValue("Hist.Binning.2D.x", binx);
+      gEnv->SetValue("Hist.Binning.2D.y", biny);
+    }
     if( getMapVal(command, "grid") == "grid" ) {
       gPad->SetGrid();
     }
 
-    TObject* hobj = gROOT->FindObject(histoname);
+    // Look for the result only where TTree::Draw puts it, i.e. in the
+    // current pad or, with "goff", the current directory, and take ownership.
+    TObject* hobj = gPad->GetPrimitive(histoname);
+    if( !hobj )
+      hobj = gDirectory->FindObject(histoname);
+    TH1* thathist = dynamic_cast<TH1*>(hobj);
+    fArena.Adopt(current_page, current_pad, thathist);
+    if( auto* pm = fMemory.CurrentPad() ) {
+      TTree* tree = fRootTree[iTree];
+      pm->drawbuf = MemoryAccount::DrawBufferBytes(tree);
+      pm->entrylists = MemoryAccount::EntryListBytes(hobj) +
+                       MemoryAccount::EntryListBytes(tree->GetEntryList());
+      pm->cache = tree->GetCacheSize();
+    }
     if( fVerbosity >= 3 )
       cout << "Finished drawing with return value " << nentries << endl;
 
     if( nentries == -1 ) {
       BadDraw(var + " not found");
     } else if( nentries != 0 ) {
-      if( !mtitle.empty() ) {
-        //  Generate a "unique" histogram name based on the MD5 of the drawn variable, cut, drawopt,
-        //  and plot title.
-        //  Makes it less likely to cause a name collision if two plot titles are the same.
-        //  If you draw the exact same plot twice, the histograms will have the same name, but
-        //  since they are exactly the same, you likely won't notice (or it will complain at you).
-        TString tmpstring(var);
-        tmpstring += cut.GetTitle();
-        tmpstring += mopt;
-        tmpstring += mtitle;
-        TString myMD5 = tmpstring.MD5();
-        TH1* thathist = (TH1*) hobj;
-        thathist->SetNameTitle(myMD5, mtitle.c_str());
-        SaveImage(thathist, command);
-      }
+      if( thathist && !mtitle.empty() )
+        thathist->SetNameTitle(padid, mtitle.c_str());
+      DrawScatterNote(scatnote);
+      // Scatter plots are drawn as graphs over an empty histogram
+      if( thathist && !HasGraph(gPad) )
+        fSnapshot.Put(padid.Data(), thathist);
+      if( fGoldenTreeFile && command.find("noshowgolden") == command.end() )
+        DrawGoldenTree(thathist, command);
+      else
+        UseDisplayCopy(thathist, command);
+      if( thathist && !mtitle.empty() )
+        SaveImage(command);
+      return thathist;
     } else {
       BadDraw("Empty Histogram");
     }
@@ -1228,9 +2693,93 @@ void OnlineGUI::TreeDraw( const cmdmap_t& command )
       // below... maybe I can come up with something better
       GetFileObjects();
       GetRootTree();
-      GetTreeVars();
     }
   }
+  return nullptr;
+}
+
+Long64_t OnlineGUI::SegmentTreeDraw( TChain* chain, const TString& var,
+                                    const TCut& cut, const string& opt,
+                                    const TString& hname )
+{
+  // Draw one-dimensional 'var' from a multi-segment run in watchfile mode
+  // into histogram 'hname'. The result for the completed segments is kept,
+  // so that on update only the entries of newly completed segments and of
+  // the last, growing, segment are processed. The binning is fixed by the
+  // first draw. If later entries fall outside of it, e.g. for a variable
+  // that keeps growing, all entries are drawn again, now and on every later
+  // update of the run. Returns the number of entries in the histogram, or
+  // -1 on error.
+
+  Long64_t total = chain->GetEntries();
+  Int_t ntrees = chain->GetNtrees();
+  Long64_t ncomplete = ntrees > 0 ? chain->GetTreeOffset()[ntrees - 1] : 0;
+  SegmentDraw& sd = fSegmentDraws[hname.Data()];
+  if( sd.entries > ncomplete ) {
+    sd.hist.reset();
+    sd.entries = 0;
+    sd.full = kFALSE;
+  }
+  auto drawall = [&]() {
+    fIOStats.Begin(chain, current_page, current_pad, var.Data());
+    Long64_t n = BoundedTreeDraw(chain, var + ">>" + hname, cut, opt);
+    fIOStats.End();
+    return n;
+  };
+  if( sd.full || (!sd.hist && ncomplete == 0) )
+    return drawall();
+
+  // Entries in the under- and overflow bins
+  auto outside = []( const TH1* h ) {
+    return h->GetBinContent(0) + h->GetBinContent(h->GetNbinsX() + 1);
+  };
+  fIOStats.Begin(chain, current_page, current_pad, var.Data());
+  bool moved = false;
+  if( ncomplete > sd.entries ) {
+    TString target = var + (sd.hist ? ">>+" : ">>") + hname;
+    Double_t before = 0;
+    if( sd.hist ) {
+      sd.hist->SetDirectory(gDirectory);
+      before = outside(sd.hist.get());
+    }
+    Long64_t n = chain->Draw(target, cut, "goff", ncomplete - sd.entries,
+                             sd.entries);
+    if( !sd.hist )
+      sd.hist.reset(dynamic_cast<TH1*>(gDirectory->FindObject(hname)));
+    else
+      moved = outside(sd.hist.get()) > before;
+    if( n < 0 || !sd.hist ) {
+      fIOStats.End();
+      sd.hist.reset();
+      return -1;
+    }
+    sd.hist->SetDirectory(nullptr);
+    sd.entries = ncomplete;
+  }
+  TH1* hist = nullptr;
+  if( !moved ) {
+    hist = static_cast<TH1*>(sd.hist->Clone(hname));
+    if( total > ncomplete ) {
+      Double_t before = outside(hist);
+      hist->SetDirectory(gDirectory);
+      chain->Draw(var + ">>+" + hname, cut, "goff", total - ncomplete,
+                  ncomplete);
+      moved = outside(hist) > before;
+    }
+  }
+  fIOStats.End();
+  if( moved ) {
+    if( fVerbosity >= 1 )
+      cout << "New entries of " << var << " outside of the range of the "
+           << "first draw; drawing all entries" << endl;
+    delete hist;
+    sd.hist.reset();
+    sd.entries = 0;
+    sd.full = kTRUE;
+    return drawall();
+  }
+  hist->Draw(opt.c_str());
+  return static_cast<Long64_t>(hist->GetEntries());
 }
 
 void OnlineGUI::PrintToFile()
@@ -1262,11 +2811,11 @@ void OnlineGUI::PrintPages()
   // Routine to go through each defined page, and print the output to
   // a postscript file. (good for making sample histograms).
 
-  if( !fRootFile )
+  if( !fRootFile && !fMapFile )
     throw runtime_error("No ROOT file");
 
-  fCanvas = new TCanvas("fCanvas", "trythis", 1000, 800);
-  auto* lt = new TLatex();
+  fCanvas = GetPrintCanvas();
+  TLatex lt;
 
   Bool_t pagePrint = kFALSE;
   TString printFormat = fConfig.GetPlotFormat();
@@ -1279,11 +2828,20 @@ void OnlineGUI::PrintPages()
   string protofilename = pagePrint ? fConfig.GetProtoPlotPageFile()
                                    : fConfig.GetProtoPlotFile();
   TString filename;
+  string plotfile, pagedigests;
   if( !pagePrint ) {
     filename = SubstitutePlaceholders(protofilename);
     auto outdir = DirnameStr(filename.Data());
     if( MakePlotsDir(outdir) )
       throw runtime_error("Bad directory name");
+    // With an output manifest, the multi-page file is written to a local
+    // temporary file first, and replaces the plot file only if any page
+    // changed
+    if( fManifest.IsEnabled() ) {
+      plotfile = filename.Data();
+      filename = Form("%s/panguin_%d_%s", gSystem->TempDirectory(),
+                      gSystem->GetPid(), BasenameStr(plotfile).c_str());
+    }
   }
 
   TString pagehead = "Summary Plots";
@@ -1302,6 +2860,10 @@ void OnlineGUI::PrintPages()
   gStyle->SetHistFillStyle(0);
   if( !pagePrint )
     fCanvas->Print(filename + "[");
+  fRecordTrend = fTrend.IsEnabled() && runNumber != 0;
+  if( fTrend.IsEnabled() && runNumber == 0 )
+    cerr << "WARNING: Run number unknown, no pad metrics recorded in the "
+         << "trend file" << endl;
   for( Int_t i = 0; i < SINT(fConfig.GetPageCount()); i++ ) {
     current_page = i;
     DoDraw();
@@ -1310,21 +2872,461 @@ void OnlineGUI::PrintPages()
     pagename += i + 1;
     pagename += ": ";
     pagename += fConfig.GetPageTitle(current_page);
-    lt->SetTextSize(0.025);
-    lt->DrawLatex(0.05, 0.98, pagename);
+    lt.SetTextSize(0.025);
+    lt.DrawLatex(0.05, 0.98, pagename);
+    string digest;
+    if( fManifest.IsEnabled() ) {
+      digest = OutputManifest::Digest(fCanvas, printFormat.Data());
+      pagedigests += digest;
+    }
     if( pagePrint ) {
       filename = SubstitutePlaceholders(protofilename);
+      if( fManifest.IsUnchanged(filename.Data(), digest) ) {
+        if( fVerbosity >= 1 )
+          cout << "Page " << current_page + 1 << " unchanged, file = "
+               << filename << endl;
+        continue;
+      }
       cout << "Printing page " << current_page + 1
            << " to file = " << filename << endl;
       auto outdir = DirnameStr(filename.Data());
       if( MakePlotsDir(outdir) )
         throw runtime_error("Bad directory name");
     }
+    Profiler::Span span(fProfiler, "SaveAs", current_page, -1, filename.Data());
     fCanvas->Print(filename);
+    if( pagePrint )
+      fManifest.Update(filename.Data(), digest);
   }
-  if( !pagePrint )
+  if( !pagePrint ) {
     fCanvas->Print(filename + "]");
+    if( !plotfile.empty() ) {
+      string digest = HashDigest(pagedigests);
+      if( fManifest.IsUnchanged(plotfile, digest) ) {
+        cout << "Plots unchanged, file = " << plotfile << endl;
+      } else if( gSystem->CopyFile(filename, plotfile.c_str(), kTRUE) == 0 ) {
+        fManifest.Update(plotfile, digest);
+      } else {
+        cerr << "ERROR: Cannot copy " << filename << " to " << plotfile << endl;
+      }
+      gSystem->Unlink(filename);
+    }
+  }
+
+  fRecordTrend = kFALSE;
+  fTrend.Flush();
+  fManifest.Save();
+  fManifest.PrintSummary(cout);
+  if( fVerbosity >= 1 )
+    cout << "Off-screen canvases: " << fCanvasPool.GetCreated() << " created, "
+         << fCanvasPool.GetReused() << " reused" << endl;
+  fSnapshot.Close();
+  fMemory.PrintSummary(cout);
+  fIOStats.PrintSummary(cout);
+  WriteMemoryReport();
+
+}
+
+void OnlineGUI::CheckRunPlaceholder() const
+{
+  // Warn if the output of consecutive runs would go to the same file
+  const string& plotfile = fConfig.GetPlotFormat() == "pdf"
+                           ? fConfig.GetProtoPlotFile()
+                           : fConfig.GetProtoPlotPageFile();
+  if( plotfile.find("%R") == string::npos )
+    cerr << "Warning: Plot file name " << plotfile << " does not contain the "
+         << "run number (%R). Each run will overwrite the previous one."
+         << endl;
+}
+
+OnlineGUI::RunTiming OnlineGUI::PrintRun( Int_t run, Bool_t& openGolden,
+                                         const string& filename )
+{
+  // Look up the ROOT file of 'run', unless given as 'filename', open it and
+  // print its summary plots. The golden files are opened with the first run
+  // and then kept.
+
+  using run_clock = std::chrono::steady_clock;
+  cout << "Processing run " << run << endl;
+  string runname = to_string(run);
+  Profiler::Span span(fProfiler, "run", -1, -1, runname.c_str());
+  RunTiming t{run, 0, 0, "ok"};
+  auto start = run_clock::now();
+  bool found = filename.empty() ? fConfig.OverrideRootFile(run)
+                                : fConfig.SetRunFile(run, filename);
+  if( !found ) {
+    t.status = "no file";
+  } else if( PrepareRootFiles(openGolden) || !fRootFile ) {
+    t.status = "open error";
+  } else {
+    openGolden = kFALSE;
+    auto opened = run_clock::now();
+    t.open = std::chrono::duration<double>(opened - start).count();
+    try {
+      PrintPages();
+    }
+    catch( const exception& e ) {
+      cerr << "Error printing run " << run << ": " << e.what() << endl;
+      t.status = "print error";
+    }
+    t.print = std::chrono::duration<double>(run_clock::now() - opened).count();
+  }
+  return t;
+}
 
+Int_t OnlineGUI::PrintRuns()
+{
+  // Print the summary plots of each run of a multi-run job. The
+  // configuration is parsed, libraries are loaded and macros are compiled
+  // only once. Output file names should contain the run number (%R), which
+  // the default names do. Returns the number of runs that failed.
+
+  CheckRunPlaceholder();
+  vector<RunTiming> timing;
+  Int_t nfail = 0;
+  Bool_t openGolden = kTRUE;
+  for( Int_t run: fConfig.GetRuns() ) {
+    timing.push_back(PrintRun(run, openGolden));
+    if( !timing.back().IsOK() )
+      ++nfail;
+  }
+
+  ios::fmtflags flags = cout.flags();
+  streamsize prec = cout.precision();
+  Double_t total = 0;
+  cout << fixed << setprecision(2)
+       << "Run summary:" << endl
+       << "     run   open[s]  print[s]  total[s]  status" << endl;
+  for( const auto& t: timing ) {
+    cout << "  " << setw(6) << t.run
+         << setw(10) << t.open
+         << setw(10) << t.print
+         << setw(10) << t.open + t.print
+         << "  " << t.status << endl;
+    total += t.open + t.print;
+  }
+  size_t nok = timing.size() - nfail;
+  cout << "  " << nok << " of " << timing.size() << " runs printed in "
+       << total << " s";
+  if( nok > 0 )
+    cout << " (" << total / nok << " s/run)";
+  cout << endl;
+  cout.flags(flags);
+  cout.precision(prec);
+  return nfail;
+}
+
+static volatile sig_atomic_t gDaemonStop = 0;
+
+static void DaemonSignal( int )
+{
+  gDaemonStop = 1;
+}
+
+//_____________________________________________________________________________
+// True if 'filename' is a ROOT file that was closed by its writer. A file
+// still being written needs recovery when opened.
+static Bool_t IsClosedRootFile( const string& filename )
+{
+  TFile f(filename.c_str(), "READ");
+  return !f.IsZombie() && !f.TestBit(TFile::kRecovered);
+}
+
+Int_t OnlineGUI::RunDaemon( const string& statefile, Int_t interval,
+                            Int_t settle, Int_t firstrun )
+{
+  // Watch the protorootfile directories for the ROOT files of new runs and
+  // print the summary plots of each one once the file is complete: its size
+  // and modification time have not changed for 'settle' seconds, and it was
+  // closed properly. Completed runs are appended to 'statefile', so that a
+  // restarted daemon skips them. A run that failed is retried only when its
+  // file changes. Runs below 'firstrun' are ignored. Stops on SIGINT or
+  // SIGTERM.
+
+  struct FileState {
+    Long64_t size;
+    Long_t mtime;
+    time_t since;    // Unchanged since
+    Bool_t failed;
+  };
+
+  set<Int_t> done;
+  {
+    ifstream ifs(statefile);
+    string line;
+    while( getline(ifs, line) ) {
+      istringstream istr(line);
+      Int_t run;
+      if( istr >> run )
+        done.insert(run);
+    }
+  }
+  if( MakePlotsDir(DirnameStr(statefile)) )
+    return 1;
+  ofstream state(statefile, ios::app);
+  if( !state ) {
+    cerr << "ERROR: Cannot open daemon state file " << statefile << endl;
+    return 1;
+  }
+  cout << "Daemon: " << done.size() << " runs already done according to "
+       << statefile << endl;
+  CheckRunPlaceholder();
+
+  gDaemonStop = 0;
+  signal(SIGINT, DaemonSignal);
+  signal(SIGTERM, DaemonSignal);
+
+  map<Int_t, FileState> pending;
+  Bool_t openGolden = kTRUE;
+  cout << "Daemon: watching for new runs every " << interval << " s" << endl;
+  while( !gDaemonStop ) {
+    map<int, string> files;
+    fConfig.FindRunFiles(files);
+    for( const auto& file: files ) {
+      if( gDaemonStop )
+        break;
+      Int_t run = file.first;
+      if( run < firstrun || done.count(run) )
+        continue;
+      FileStat_t st;
+      if( gSystem->GetPathInfo(file.second.c_str(), st) )
+        continue;
+      time_t now = time(nullptr);
+      auto it = pending.find(run);
+      if( it == pending.end() || it->second.size != st.fSize ||
+          it->second.mtime != st.fMtime ) {
+        if( it == pending.end() && fVerbosity > 0 )
+          cout << "Daemon: found " << file.second << endl;
+        pending[run] = FileState{st.fSize, st.fMtime, now, kFALSE};
+        continue;
+      }
+      FileState& fs = it->second;
+      if( fs.failed || now - fs.since < settle )
+        continue;
+      if( !IsClosedRootFile(file.second) ) {
+        fs.since = now;
+        continue;
+      }
+      // The file found and checked above, not another one of the run
+      RunTiming t = PrintRun(run, openGolden, file.second);
+      char stamp[32];
+      strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+      cout << "Daemon: run " << run << " " << t.status << " after "
+           << t.open + t.print << " s" << endl;
+      if( t.IsOK() ) {
+        done.insert(run);
+        pending.erase(it);
+        state << run << " " << t.status << " " << stamp << " "
+              << t.open + t.print << endl;
+      } else
+        fs.failed = kTRUE;
+    }
+    for( Int_t i = 0; i < interval && !gDaemonStop; ++i )
+      gSystem->Sleep(1000);
+  }
+  cout << "Daemon: stopping" << endl;
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+  return 0;
+}
+
+void OnlineGUI::CompareGolden()
+{
+  // Batch comparison of every histogram found in both the ROOT file and the
+  // golden file. The statistical tests run in parallel. Writes a report
+  // (JSON, or CSV if the report file name ends in .csv) and a summary page
+  // listing the histograms in order of increasing agreement.
+
+  if( !fRootFile )
+    throw runtime_error("No ROOT file");
+  if( !doGolden ) {
+    cerr << "ERROR: Comparison requested, but no golden ROOT file available"
+         << endl;
+    return;
+  }
+
+  GoldenCompare compare(fConfig.DoCompareNormDiff());
+  set<string> seen;
+  for( const auto& fileObject: fileObjects ) {
+    if( !fileObject.second.BeginsWith("TH") )
+      continue;
+    string name = fileObject.first.Data();
+    if( !seen.insert(name).second )
+      continue;  // Another cycle of the same key
+    TH1* hist = nullptr;
+    fRootFile->GetObject(name.c_str(), hist);
+    compare.Add(name, hist, GetGoldenHist(name));
+  }
+  compare.Run();
+  const auto& results = compare.GetResults();
+
+  const string& reportfile = fConfig.GetCompareFile();
+  if( MakePlotsDir(DirnameStr(reportfile)) == 0 &&
+      compare.WriteReport(reportfile) == 0 )
+    cout << "Comparison of " << results.size() << " histograms written to "
+         << reportfile << endl;
+
+  // Summary page, worst agreement first
+  const size_t maxrows = 40;
+  string pagefile = reportfile;
+  auto pos = pagefile.rfind('.');
+  if( pos != string::npos && pagefile.find('/', pos) == string::npos )
+    pagefile.erase(pos);
+  pagefile += "." + fConfig.GetPlotFormat();
+
+  auto c = fCanvasPool.Acquire(1000, 800);
+  TString pagehead = "Golden comparison";
+  if( runNumber != 0 ) {
+    pagehead += " (Run #";
+    pagehead += runNumber;
+    pagehead += ")";
+  }
+  pagehead += ", worst agreement first";
+  TPaveText pt(0.02, 0.02, 0.98, 0.98, "brNDC");
+  pt.SetBorderSize(0);
+  pt.SetFillColor(10);
+  pt.SetTextAlign(12);
+  pt.SetTextFont(82);
+  pt.AddText(pagehead.Data());
+  pt.AddText(Form("%-4s %-32s %10s %12s %10s  %s", "#", "Histogram", "KS prob",
+                  "chi2/ndf", "normdiff", "status"));
+  for( size_t i = 0; i < results.size() && i < maxrows; ++i ) {
+    const auto& r = results[i];
+    double chi2ndf = r.ndf > 0 ? r.chi2 / r.ndf : -1;
+    auto* t = pt.AddText(Form("%-4zu %-32.32s %10.3g %12.4g %10.3g  %s",
+                              i + 1, r.name.c_str(), r.ks, chi2ndf,
+                              r.normdiff, r.status.c_str()));
+    if( r.IsOk() && r.Score() < 0.01 )
+      t->SetTextColor(2);
+  }
+  if( results.size() > maxrows )
+    pt.AddText(Form("... %zu more in %s", results.size() - maxrows,
+                    reportfile.c_str()));
+  pt.Draw();
+  if( MakePlotsDir(DirnameStr(pagefile)) == 0 )
+    c->Print(pagefile.c_str());
+
+  if( fVerbosity >= 1 ) {
+    for( size_t i = 0; i < results.size() && i < 10; ++i ) {
+      const auto& r = results[i];
+      cout << setw(4) << i + 1 << "  " << setw(32) << left << r.name << right
+           << "  KS = " << r.ks << "  chi2/ndf = " << r.chi2 << "/" << r.ndf
+           << "  " << r.status << endl;
+    }
+  }
+}
+
+void OnlineGUI::BuildGoldenTreeCache()
+{
+  // Run all tree-variable pads of the configuration against the golden run,
+  // which has been opened as the input file, and store the resulting
+  // histograms, keyed by pad identity, in the golden tree-draw file.
+  // Subsequent runs overlay these references in TreeDraw().
+
+  if( !fRootFile )
+    throw runtime_error("No ROOT file");
+
+  const string& outname = fConfig.GetGoldenTreeFile();
+  if( MakePlotsDir(DirnameStr(outname)) )
+    throw runtime_error("Bad directory name");
+  TFile outfile(outname.c_str(), "RECREATE");
+  if( !outfile.IsOpen() )
+    throw runtime_error("Cannot create golden tree-draw file " + outname);
+
+  auto c = fCanvasPool.Acquire(1000, 800);
+  fCanvas = c.get();
+
+  cmdmap_t drawcommand;
+  Int_t nstored = 0;
+  for( Int_t i = 0; i < SINT(fConfig.GetPageCount()); i++ ) {
+    current_page = i;
+    UInt_t draw_count = fConfig.GetDrawCount(current_page);
+    for( Int_t j = 0; j < SINT(draw_count); j++ ) {
+      current_pad = j + 1;
+      fConfig.GetDrawCommand(current_page, current_pad - 1, drawcommand);
+      const string& cmd = getMapVal(drawcommand, "variable");
+      if( cmd.empty() || cmd == "macro" || cmd == "loadmacro" ||
+          cmd == "loadlib" || IsHistogram(cmd) )
+        continue;
+      c->Clear();
+      fArena.ReleaseAll();
+      c->cd();
+      fRootFile->cd();
+      TH1* hist = TreeDraw(drawcommand);
+      if( !hist )
+        continue;
+      TString padid = GetPadIdentity(drawcommand);
+      if( fVerbosity >= 1 )
+        cout << "Golden reference " << padid << " = " << cmd << endl;
+      outfile.WriteTObject(hist, padid, "Overwrite");
+      ++nstored;
+    }
+  }
+  c->Clear();
+  fArena.ReleaseAll();
+  fCanvas = nullptr;
+
+  TNamed source("panguin_golden_source", fConfig.GetRootFile());
+  outfile.WriteTObject(&source);
+  outfile.Close();
+  cout << "Stored " << nstored << " golden tree-draw histograms in "
+       << outname << endl;
+}
+
+TCanvas* OnlineGUI::GetPrintCanvas()
+{
+  // Canvas for drawing pages in batch mode. Created once and reused.
+  if( !fPrintCanvas )
+    fPrintCanvas = fCanvasPool.Acquire(1000, 800);
+  return fPrintCanvas.get();
+}
+
+void OnlineGUI::SoakTest( Int_t nupdates )
+{
+  // Redraw all pages 'nupdates' times without writing any output, like a
+  // long-running monitor would, and report resident memory and the number
+  // of objects owned by panguin along the way. Both should stay flat.
+  // With "watchfile", the ROOT files are reopened for every update.
+
+  if( !fRootFile )
+    throw runtime_error("No ROOT file");
+  fCanvas = GetPrintCanvas();
+
+  ProcInfo_t info;
+  Long_t rss0 = 0;
+  Int_t step = max(1, nupdates / 20);
+  for( Int_t n = 1; n <= nupdates; ++n ) {
+    if( fConfig.IsMonitor() && PrepareRootFiles() )
+      throw runtime_error("Error reopening ROOT file");
+    for( Int_t i = 0; i < SINT(fConfig.GetPageCount()); i++ ) {
+      current_page = i;
+      DoDraw();
+    }
+    if( n == 1 || n % step == 0 || n == nupdates ) {
+      gSystem->GetProcInfo(&info);
+      if( n == 1 )
+        rss0 = info.fMemResident;
+      cout << "Update " << setw(6) << n
+           << ": resident memory = " << info.fMemResident << " kB"
+           << " (" << showpos << info.fMemResident - rss0 << noshowpos
+           << " kB), owned objects = " << fArena.GetSize() << endl;
+    }
+  }
+  fCanvas->Clear();
+  fArena.ReleaseAll();
+  WriteMemoryReport();
+}
+
+void OnlineGUI::WriteMemoryReport() const
+{
+  // Write the memory use of the most recent draw of each page to the file
+  // given with --memory-report, if any
+  const string& reportfile = fConfig.GetMemoryReportFile();
+  if( reportfile.empty() )
+    return;
+  if( MakePlotsDir(DirnameStr(reportfile)) == 0 &&
+      fMemory.WriteJSON(reportfile) == 0 )
+    cout << "Memory report written to " << reportfile << endl;
 }
 
 //_____________________________________________________________________________
@@ -1338,6 +3340,7 @@ void OnlineGUI::DeleteGUI()
 {
   DelPtr(timer);
   DelPtr(timerNow);
+  DelPtr(fZoomTimer);
   DelPtr(fPrint);
   DelPtr(fExit);
   DelPtr(fRunNumber);
@@ -1362,6 +3365,7 @@ void OnlineGUI::MyCloseWindow()
   if( timer ) {
     timer->Stop();
   }
+  WriteMemoryReport();
   DeleteGUI();
 
   gApplication->Terminate();
@@ -1379,10 +3383,24 @@ OnlineGUI::~OnlineGUI()
 {
   if( timer )
     timer->Stop();
+  if( fZoomTimer )
+    fZoomTimer->Stop();
+  if( fMain && fDisplay.IsEnabled() ) {
+    TQObject::Disconnect("TPad", "RangeAxisChanged()", this, "DisplayZoomed()");
+    TQObject::Disconnect("TPad", "UnZoomed()", this, "DisplayZoomed()");
+  }
+  fProfiler.Finish();
+  fIOStats.Finish();
   if( fMain ) {
     fMain->SendCloseMessage();
     DeleteGUI();
   }
+  fPrintCanvas.reset();
+  fArena.ReleaseAll();
+  fGoldenCache.clear();
+  fGoldenTreeCache.clear();
+  DelPtr(fGoldenTreeFile);
   DelPtr(fGoldenFile);
   DelPtr(fRootFile);
+  DelPtr(fMapFile);
 }
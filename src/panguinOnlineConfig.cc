@@ -10,7 +10,9 @@
 #include <cctype>     // isalnum, isdigit
 #include <algorithm>  // find_if
 #include <type_traits>// make_signed
+#include <cstdint>
 #include <sys/stat.h>
+#include <dirent.h>
 #if __cplusplus >= 201703L
 #include <regex>
 #endif
@@ -42,6 +44,77 @@ bool EndsWith( const string& str, const string& tail )
   return sl >= tl && str.substr(sl - tl, tl) == tail;
 }
 
+//_____________________________________________________________________________
+// 64-bit FNV-1a hash of 'data', in hex. Stable across processes and
+// platforms, for digests stored in files.
+string HashDigest( const string& data )
+{
+  uint64_t h = 14695981039346656037ULL;
+  for( unsigned char c: data ) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  ostringstream ostr;
+  ostr << hex << setw(16) << setfill('0') << h;
+  return ostr.str();
+}
+
+//_____________________________________________________________________________
+// Return 'str' as a double-quoted JSON string literal with special characters
+// escaped. Used for the machine-readable reports.
+string JsonQuote( const string& str )
+{
+  ostringstream ostr;
+  ostr << '"';
+  for( char c: str ) {
+    switch( c ) {
+      case '"':  ostr << "\\\""; break;
+      case '\\': ostr << "\\\\"; break;
+      case '\n': ostr << "\\n"; break;
+      case '\t': ostr << "\\t"; break;
+      case '\r': ostr << "\\r"; break;
+      default:
+        if( static_cast<unsigned char>(c) < 0x20 )
+          ostr << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec;
+        else
+          ostr << c;
+    }
+  }
+  ostr << '"';
+  return ostr.str();
+}
+
+//_____________________________________________________________________________
+// Most points a stripchart pad may keep (-npoints)
+static const long kMaxNPoints = 1000000;
+
+// Check that 'str' is a valid -npoints value
+static bool IsNPoints( const string& str )
+{
+  try {
+    size_t pos = 0;
+    long n = stol(str, &pos);
+    return pos == str.size() && n > 0 && n <= kMaxNPoints;
+  }
+  catch( const logic_error& ) {
+    return false;
+  }
+}
+
+// Check that 'str' is a valid -scatter mode
+static bool IsScatterMode( const string& str )
+{
+  return str == "density" || str == "sample" || str == "all";
+}
+
+//_____________________________________________________________________________
+// Return 'str' as a double-quoted CSV field (RFC 4180), with embedded double
+// quotes doubled
+string CsvQuote( const string& str )
+{
+  return '"' + ReplaceAll(str, "\"", "\"\"") + '"';
+}
+
 //_____________________________________________________________________________
 // Get directory name part of 'path'
 string DirnameStr( string path )
@@ -281,6 +354,19 @@ OnlineConfig::OnlineConfig( const CmdLineOpts& opts )
   , fImageFormat(opts.imgfmt)
   , fImagesDir(opts.imgdir)
   , plotsdir(opts.plotsdir)
+  , fCompareFile(opts.comparefile)
+  , fGoldenTreeFile(opts.goldentreefile)
+  , fMemoryReportFile(opts.memoryreport)
+  , fProfileFile(opts.profilefile)
+  , fIOStatsFile(opts.iostatsfile)
+  , fJsonDir(opts.jsondir)
+  , fSnapshotFile(opts.snapshotfile)
+  , fOutputManifest(opts.outputmanifest)
+  , fTrendFile(opts.trendfile)
+  , fMapFile(opts.mapfile)
+  , fAlarmLog(opts.alarmlog)
+  , fRuns(opts.runs)
+  , fTrendQuantiles(opts.trendquantiles)
   , fFoundCfg(false)
   , fMonitor(false)
   , fVerbosity(opts.verbosity)
@@ -290,8 +376,17 @@ OnlineConfig::OnlineConfig( const CmdLineOpts& opts )
   , fRunNoWidth(0)
   , fPageNoWidth(2)
   , fPadNoWidth(2)
+  , fSoakUpdates(opts.soakupdates)
+  , fUpdateInterval(opts.updateinterval)
+  , fDisplayMaxBins(opts.displaymaxbins)
+  , fScatterMaxPoints(opts.scattermaxpoints)
+  , fDrawBuffer(opts.drawbuffer)
   , fPrintOnly(opts.printonly)
   , fSaveImages(opts.saveimages)
+  , fCompareNormDiff(opts.comparenormdiff)
+  , fMakeGoldenTrees(opts.makegoldentrees)
+  , fIOStats(opts.iostats || !opts.iostatsfile.empty())
+  , fDaemon(opts.daemon)
 {
   // Pick up config file directory/path form environment.
   // A config dir or path given on the command line takes preference.
@@ -303,6 +398,17 @@ OnlineConfig::OnlineConfig( const CmdLineOpts& opts )
     fRootFilesPath = ExpandFileName(fRootFilesPath);
     fImagesDir = ExpandFileName(fImagesDir);
     plotsdir = ExpandFileName(plotsdir);
+    fCompareFile = ExpandFileName(fCompareFile);
+    fGoldenTreeFile = ExpandFileName(fGoldenTreeFile);
+    fMemoryReportFile = ExpandFileName(fMemoryReportFile);
+    fProfileFile = ExpandFileName(fProfileFile);
+    fIOStatsFile = ExpandFileName(fIOStatsFile);
+    fJsonDir = ExpandFileName(fJsonDir);
+    fSnapshotFile = ExpandFileName(fSnapshotFile);
+    fOutputManifest = ExpandFileName(fOutputManifest);
+    fTrendFile = ExpandFileName(fTrendFile);
+    fMapFile = ExpandFileName(fMapFile);
+    fAlarmLog = ExpandFileName(fAlarmLog);
 
     const char* env_cfgdir = getenv("PANGUIN_CONFIG_PATH");
     if( env_cfgdir )
@@ -547,6 +653,50 @@ bool OnlineConfig::ParseConfig()
         if( !IsSet(goldenrootfilename, line[0]) )
           goldenrootfilename = ExpandFileName(line[1]);
       }},
+      {"goldentreefile",
+        1, [&]( const VecStr_t& line ) {
+        if( !IsSet(fGoldenTreeFile, line[0]) )
+          fGoldenTreeFile = ExpandFileName(line[1]);
+      }},
+      {"trendfile",
+        1, [&]( const VecStr_t& line ) {
+        if( !IsSet(fTrendFile, line[0]) )
+          fTrendFile = ExpandFileName(line[1]);
+      }},
+      {"displaymaxbins",
+        1, [&]( const VecStr_t& line ) {
+        if( fDisplayMaxBins < 0 )
+          fDisplayMaxBins = stoll(line[1]);
+        else
+          cout << "Warning: --display-max-bins given on command line. "
+               << "Ignoring displaymaxbins from config file." << endl;
+      }},
+      {"scattermaxpoints",
+        1, [&]( const VecStr_t& line ) {
+        if( fScatterMaxPoints < 0 )
+          fScatterMaxPoints = stoll(line[1]);
+        else
+          cout << "Warning: --scatter-max-points given on command line. "
+               << "Ignoring scattermaxpoints from config file." << endl;
+      }},
+      {"drawbuffer",
+        1, [&]( const VecStr_t& line ) {
+        if( fDrawBuffer < 0 )
+          fDrawBuffer = stoll(line[1]);
+        else
+          cout << "Warning: --draw-buffer given on command line. "
+               << "Ignoring drawbuffer from config file." << endl;
+      }},
+      {"mapfile",
+        1, [&]( const VecStr_t& line ) {
+        if( !IsSet(fMapFile, line[0]) )
+          fMapFile = ExpandFileName(line[1]);
+      }},
+      {"alarmlog",
+        1, [&]( const VecStr_t& line ) {
+        if( !IsSet(fAlarmLog, line[0]) )
+          fAlarmLog = ExpandFileName(line[1]);
+      }},
       {"protorootfile",
         1, [&]( const VecStr_t& line ) {
         fProtoRootFiles.push_back(ExpandFileName(line[1]));
@@ -618,8 +768,56 @@ bool OnlineConfig::ParseConfig()
     cout << "Number of pages defined = " << GetPageCount() << endl;
     cout << "Number of cuts defined = " << cutList.size() << endl;
 
-    if( rootfilename.empty() && fRunNumber != 0)
-      OverrideRootFile(fRunNumber);
+    // Check numeric pad options here, once, rather than on every draw
+    for( uint_t page = 0; page < GetPageCount(); page++ ) {
+      for( uint_t index: GetDrawIndex(page) ) {
+        const VecStr_t& line = sConfFile[index];
+        if( line.empty() || line[0] == "macro" || line[0] == "loadmacro" )
+          continue;
+        for( uint_t i = 1; i + 1 < line.size(); i++ ) {
+          if( line[i] == "-npoints" && !IsNPoints(line[i + 1]) )
+            throw runtime_error("-npoints must be a number between 1 and " +
+                                to_string(kMaxNPoints) + ", not \"" +
+                                line[i + 1] + "\" (page \"" +
+                                GetPageTitle(page) + "\")");
+          if( line[i] == "-scatter" && !IsScatterMode(line[i + 1]) )
+            throw runtime_error("-scatter must be density, sample or all, "
+                                "not \"" + line[i + 1] + "\" (page \"" +
+                                GetPageTitle(page) + "\")");
+        }
+      }
+    }
+
+    if( fMakeGoldenTrees ) {
+      // Run the configuration against the golden run
+      if( goldenrootfilename.empty() )
+        throw runtime_error("Making golden tree references requires a "
+                            "golden ROOT file");
+      rootfilename = goldenrootfilename;
+    }
+
+    if( !fMapFile.empty() ) {
+      // Live histograms from a running producer, always watched
+      if( fDaemon || IsMultiRun() || fMakeGoldenTrees )
+        throw runtime_error("A map file cannot be used with multiple runs, "
+                            "the daemon or golden tree references");
+      fMonitor = true;
+      cout << "Using map file " << fMapFile << endl;
+    }
+    else if( fDaemon ) {
+      if( fProtoRootFiles.empty() )
+        throw runtime_error("Daemon mode requires a protorootfile");
+      cout << "Will watch for new ROOT files" << endl;
+    }
+    else if( rootfilename.empty() && fRunNumber != 0 ) {
+      // In a multi-run job, the ROOT file of each run is looked up in turn
+      if( IsMultiRun() )
+        cout << "Will process " << fRuns.size() << " runs" << endl;
+      else if( !OverrideRootFile(fRunNumber) )
+        throw runtime_error("No ROOT file found for run "
+                            + to_string(fRunNumber) + ". Double check your "
+                            "configuration and files.");
+    }
     else if( !rootfilename.empty() ) {
       if (fRunNumber != 0)
 	cout << "Notice: Both ROOT file and run number specified. "
@@ -637,6 +835,7 @@ bool OnlineConfig::ParseConfig()
 	     << runnum << " vs. " << fRunNumber
 	     << ".  Using commandline value: " << fRunNumber
 	     << endl;
+      FindSegments();
     }
     if( !plotsdir.empty() )
       plotsdir = ExpandFileName(plotsdir);
@@ -649,9 +848,32 @@ bool OnlineConfig::ParseConfig()
       cout << "Will compare chosen histograms with the golden rootfile: "
            << endl
            << goldenrootfilename << endl;
+      // Default golden tree-draw file: <golden file>_goldentrees.root.
+      // Used only if it exists, unless we are asked to create it.
+      if( fGoldenTreeFile.empty() ) {
+        string gtfile = goldenrootfilename;
+        if( EndsWith(gtfile, ".root") )
+          gtfile.erase(gtfile.length() - 5);
+        gtfile += "_goldentrees.root";
+        struct stat fs{};
+        if( fMakeGoldenTrees || stat(gtfile.c_str(), &fs) == 0 )
+          fGoldenTreeFile = gtfile;
+      }
+      if( !fGoldenTreeFile.empty() && !fMakeGoldenTrees )
+        cout << "Will compare tree variables with the golden tree-draw file: "
+             << endl
+             << fGoldenTreeFile << endl;
     }
 
     // Set fallback defaults
+    if( fDisplayMaxBins < 0 )
+      fDisplayMaxBins = 100000;
+    if( fScatterMaxPoints < 0 )
+      fScatterMaxPoints = 1000000;
+    if( fDrawBuffer < 0 )
+      fDrawBuffer = 1000000;
+    if( fAlarmLog.empty() )
+      fAlarmLog = "panguin_alarms.log";
     if( fPlotFormat.empty() )
       fPlotFormat = "pdf";
     if( fImageFormat.empty() )
@@ -907,8 +1129,21 @@ void OnlineConfig::GetDrawCommand(
     out_command["library"] = sConfFile[index][1]; //shared library to load
   }
 
+  // trend <pad name or identity> <metric> [options]
+  uint_t firstopt = 1;
+  if( out_command["variable"] == "trend" && sConfFile[index].size() > 2 ) {
+    out_command["trendpad"] = sConfFile[index][1];
+    out_command["metric"] = sConfFile[index][2];
+    firstopt = 3;
+  }
+  // stripchart <rate|variable> [options]
+  if( out_command["variable"] == "stripchart" && sConfFile[index].size() > 1 ) {
+    out_command["stripvar"] = sConfFile[index][1];
+    firstopt = 2;
+  }
+
   // Now go through the rest of that line..
-  for( uint_t i = 1; i < sConfFile[index].size(); i++ ) {
+  for( uint_t i = firstopt; i < sConfFile[index].size(); i++ ) {
     if( sConfFile[index][i] == "-drawopt" && i + 1 < sConfFile[index].size() ) {
       // if(out_command[2].empty()){
       //   out_command[2] = sConfFile[index][i+1];
@@ -978,6 +1213,9 @@ void OnlineConfig::GetDrawCommand(
       //   cout << "Error: Multiple trees in Page: " << page << "--" << GetPageTitle(page).Data() << "\t coomand: " << nCommand << endl;
       //   exit(1);
       // }
+    } else if( sConfFile[index][i] == "-npoints" && i + 1 < sConfFile[index].size() ) {
+      out_command["npoints"] = sConfFile[index][i + 1];
+      i++;
     } else if( sConfFile[index][i] == "-grid" ) {
       out_command["grid"] = "grid";
       // if (out_command[5].empty()){ // grid option only works with TreeDraw
@@ -992,6 +1230,21 @@ void OnlineConfig::GetDrawCommand(
       out_command["logy"] = "logy";
     } else if( sConfFile[index][i] == "-logz" ) {
       out_command["logz"] = "logz";
+    } else if( sConfFile[index][i] == "-scatter" && i + 1 < sConfFile[index].size() ) {
+      if( !IsScatterMode(sConfFile[index][i + 1]) )
+        throw runtime_error("Unknown -scatter mode \"" +
+                            sConfFile[index][i + 1] + "\"");
+      out_command["scatter"] = sConfFile[index][i + 1];
+      i++;
+    } else if( sConfFile[index][i] == "-check" && i + 1 < sConfFile[index].size() ) {
+      // Several checks of a pad are kept as one comma-separated list
+      string& checks = out_command["check"];
+      if( !checks.empty() )
+        checks += ",";
+      checks += sConfFile[index][i + 1];
+      i++;
+    } else if( sConfFile[index][i] == "-fullres" ) {
+      out_command["fullres"] = "fullres";
     } else if( sConfFile[index][i] == "-nostat" ) {
       out_command["nostat"] = "nostat";
     } else if( sConfFile[index][i] == "-noshowgolden" ) {
@@ -1021,31 +1274,61 @@ void OnlineConfig::GetDrawCommand(
   }
 }
 
+//_____________________________________________________________________________
+// Digest of the configuration as loaded, including any included files.
+// Identifies results made with the same configuration.
+string OnlineConfig::GetConfigDigest() const
+{
+  string text;
+  for( const auto& line: sConfFile ) {
+    for( const auto& word: line ) {
+      text += word;
+      text += '\0';
+    }
+    text += '\n';
+  }
+  return HashDigest(text);
+}
+
+//_____________________________________________________________________________
+// Search path for ROOT files: --root-dir, $ROOTFILES, ./rootfiles
+string OnlineConfig::GetRootFilesSearchPath() const
+{
+  string path;
+  AppendToPath(path, fRootFilesPath);
+  auto* envar = getenv("ROOTFILES");
+  if( envar )
+    AppendToPath(path, envar);
+  AppendToPath(path, "rootfiles");
+  return path;
+}
+
 //_____________________________________________________________________________
 // Override the ROOT file defined in the cfg file. This is called when the
-// user specifies a run number on the command line.
-void OnlineConfig::OverrideRootFile( int runnumber )
+// user specifies a run number on the command line, and for each run of a
+// multi-run job. Returns false if no file was found for this run.
+bool OnlineConfig::OverrideRootFile( int runnumber )
 {
   if( !rootfilename.empty() )
     cout << "Root file defined before was: " << rootfilename << endl;
 
-  string fnmRootPath;
-  AppendToPath(fnmRootPath, fRootFilesPath);
-  auto* envar = getenv("ROOTFILES");
-  if( envar )
-    AppendToPath(fnmRootPath, envar);
-  AppendToPath(fnmRootPath, "rootfiles");
+  string fnmRootPath = GetRootFilesSearchPath();
 
   bool found = false;
-  for( auto& protofile: fProtoRootFiles ) {
+  for( const auto& proto: fProtoRootFiles ) {
     // try opening protofile in path
-    assert(!protofile.empty());  // else error in ParseConfig
-    cout << " Looking for protoROOT file " << protofile
+    assert(!proto.empty());  // else error in ParseConfig
+    cout << " Looking for protoROOT file " << proto
 	 << " with runnumber " << runnumber
          << " in " << fnmRootPath << endl;
-    protofile = SubstituteRunNumber(protofile, runnumber);
+    string protofile = SubstituteRunNumber(proto, runnumber);
     ifstream ifs;
     string fp = OpenInPath(protofile, fnmRootPath, ifs);
+    if( !ifs && EndsWith(protofile, ".root") ) {
+      // Runs split into segments may start with <name>.000.root
+      protofile.insert(protofile.length() - 5, ".000");
+      fp = OpenInPath(protofile, fnmRootPath, ifs);
+    }
     if( ifs ) {
       rootfilename = fp + "/" + BasenameStr(protofile);
       found = true;
@@ -1054,13 +1337,143 @@ void OnlineConfig::OverrideRootFile( int runnumber )
   }
 
   if( !found ) {
-    cout << "No ROOT file found. Double check your configurations and files. "
-         << "Quitting ..." << endl;
-    exit(1);
+    cout << "No ROOT file found for run " << runnumber << endl;
+    return false;
   }
   cout << "\t found file " << rootfilename << endl;
 
   fRunNumber = runnumber;
+  FindSegments();
+  return true;
+}
+
+//_____________________________________________________________________________
+// Like OverrideRootFile, but with the ROOT file of the run already known,
+// e.g. found by FindRunFiles
+bool OnlineConfig::SetRunFile( int runnumber, const string& filename )
+{
+  if( filename.empty() )
+    return false;
+  rootfilename = filename;
+  fRunNumber = runnumber;
+  FindSegments();
+  return true;
 }
 
 //_____________________________________________________________________________
+// If 'name' is a segment of a run split into several files, i.e.
+// <stem>.<number>.root with up to 3 digits, or possibly the first segment,
+// <stem>.root,
+// set 'stem' and return the segment number (-1 for <stem>.root).
+// Returns -2 if 'name' does not end in .root.
+static int SegmentNumber( const string& name, string& stem )
+{
+  if( !EndsWith(name, ".root") )
+    return -2;
+  stem = name.substr(0, name.length() - 5);
+  auto pos = stem.rfind('.');
+  if( pos == string::npos || pos + 1 == stem.length() ||
+      stem.length() - pos > 4 ||
+      !all_of(stem.begin() + pos + 1, stem.end(),
+              []( char c ) { return isdigit(c); }) )
+    return -1;
+  int seg = stoi(stem.substr(pos + 1));
+  stem.erase(pos);
+  return seg;
+}
+
+//_____________________________________________________________________________
+// Find all segments of the current ROOT file's run: files named
+// <stem>.root and <stem>.<number>.root in the same directory, where the
+// ROOT file is one of them. The ROOT file becomes the first segment.
+// A ROOT file that is not segmented is the only segment.
+void OnlineConfig::FindSegments()
+{
+  fRootSegments.clear();
+  if( rootfilename.empty() )
+    return;
+  string dir = DirnameStr(rootfilename), stem;
+  string prefix = rootfilename.find('/') != string::npos ? dir + "/" : "";
+  if( SegmentNumber(BasenameStr(rootfilename), stem) < -1 ) {
+    fRootSegments.push_back(rootfilename);
+    return;
+  }
+  map<int, string> segments;
+  DIR* dirp = opendir(dir.c_str());
+  if( dirp ) {
+    while( const struct dirent* ent = readdir(dirp) ) {
+      string segstem;
+      int seg = SegmentNumber(ent->d_name, segstem);
+      if( seg >= -1 && segstem == stem )
+        segments[seg] = prefix + ent->d_name;
+    }
+    closedir(dirp);
+  }
+  if( segments.size() <= 1 ) {
+    fRootSegments.push_back(rootfilename);
+    return;
+  }
+  for( const auto& seg: segments )
+    fRootSegments.push_back(seg.second);
+  rootfilename = fRootSegments.front();
+  cout << "Run consists of " << fRootSegments.size()
+       << " segments, starting with " << rootfilename << endl;
+}
+
+//_____________________________________________________________________________
+// Find the ROOT files of all runs present in the directories searched by
+// OverrideRootFile, i.e. files matching one of the protorootfile names with
+// the run number placeholder replaced by digits. Fills 'files' with
+// run number -> file name. As in OverrideRootFile, the first protorootfile
+// and the first directory in the search path take precedence.
+void OnlineConfig::FindRunFiles( map<int, string>& files ) const
+{
+  string path = GetRootFilesSearchPath();
+  for( const auto& proto: fProtoRootFiles ) {
+    string base = BasenameStr(proto);
+    string placeholder = "%R";
+    auto pos = base.find(placeholder);
+    if( pos == string::npos ) {
+      placeholder = "XXXXX";
+      pos = base.find(placeholder);
+      if( pos == string::npos )
+        continue;
+    }
+    string prefix = base.substr(0, pos);
+    string suffix = base.substr(pos + placeholder.length());
+    string protodir = DirnameStr(proto);
+
+    // Relative names are tried in the current directory first
+    vector<string> dirs{protodir};
+    if( proto[0] != '/' ) {
+      istringstream istr(path);
+      string dir;
+      while( getline(istr, dir, ':') ) {
+        if( !dir.empty() )
+          dirs.push_back(protodir == "." ? dir : dir + "/" + protodir);
+      }
+    }
+    for( const auto& dir: dirs ) {
+      DIR* dirp = opendir(dir.c_str());
+      if( !dirp )
+        continue;
+      while( const struct dirent* ent = readdir(dirp) ) {
+        string name = ent->d_name;
+        if( name.length() <= prefix.length() + suffix.length() ||
+            name.compare(0, prefix.length(), prefix) != 0 ||
+            !EndsWith(name, suffix) )
+          continue;
+        string digits = name.substr(prefix.length(),
+                                    name.length() - prefix.length()
+                                    - suffix.length());
+        if( digits.length() > 9 ||
+            !all_of(ALL(digits), []( char c ) { return isdigit(c); }) )
+          continue;
+        int run = stoi(digits);
+        if( run > 0 && !files.count(run) )
+          files[run] = dir + "/" + name;
+      }
+      closedir(dirp);
+    }
+  }
+}
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////
+//  Profiler: timed processing stages, Chrome trace-event output
+//  StartupTimer: startup breakdown
+///////////////////////////////////////////////////////////////////
+
+#include "panguinProfile.hh"
+#include "panguinOnlineConfig.hh"  // JsonQuote
+#include <TSystem.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+void Profiler::Enable( const string& tracefile )
+{
+  lock_guard<mutex> lock(fMutex);
+  fTraceFile = tracefile;
+  fEvents.clear();
+  fThreads.clear();
+  fT0 = chrono::steady_clock::now();
+  fEnabled = true;
+}
+
+//_____________________________________________________________________________
+double Profiler::Now() const
+{
+  return chrono::duration<double, micro>(chrono::steady_clock::now() - fT0)
+    .count();
+}
+
+//_____________________________________________________________________________
+void Profiler::Record( const char* name, int page, int pad, const char* detail,
+                       double start, double duration )
+{
+  lock_guard<mutex> lock(fMutex);
+  auto ins = fThreads.insert(make_pair(this_thread::get_id(),
+                                       static_cast<int>(fThreads.size()) + 1));
+  fEvents.push_back({name, detail ? detail : "", page, pad,
+                     ins.first->second, start, duration});
+}
+
+//_____________________________________________________________________________
+int Profiler::Finish()
+{
+  if( !fEnabled )
+    return 0;
+  fEnabled = false;
+  PrintSummary(cout);
+  int ret = WriteTrace(fTraceFile);
+  if( ret == 0 )
+    cout << "Profile written to " << fTraceFile << endl;
+  return ret;
+}
+
+//_____________________________________________________________________________
+// Totals per stage, followed by the slowest pads
+void Profiler::PrintSummary( ostream& os ) const
+{
+  lock_guard<mutex> lock(fMutex);
+  if( fEvents.empty() )
+    return;
+  struct Stat {
+    size_t n{0};
+    double sum{0}, max{0};
+  };
+  map<string, Stat> stats;
+  vector<const Event*> pads;
+  for( const auto& ev: fEvents ) {
+    Stat& st = stats[ev.name];
+    ++st.n;
+    st.sum += ev.duration;
+    st.max = max(st.max, ev.duration);
+    if( ev.pad > 0 && string(ev.name) == "pad" )
+      pads.push_back(&ev);
+  }
+  vector<pair<string, Stat>> sorted(stats.begin(), stats.end());
+  sort(sorted.begin(), sorted.end(),
+       []( const pair<string, Stat>& a, const pair<string, Stat>& b ) {
+         return a.second.sum > b.second.sum;
+       });
+
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  os << fixed << setprecision(2)
+     << "Profile summary:" << endl
+     << "  " << left << setw(20) << "stage" << right
+     << setw(8) << "calls" << setw(12) << "total[ms]"
+     << setw(12) << "mean[ms]" << setw(12) << "max[ms]" << endl;
+  for( const auto& s: sorted ) {
+    os << "  " << left << setw(20) << s.first << right
+       << setw(8) << s.second.n
+       << setw(12) << s.second.sum / 1e3
+       << setw(12) << s.second.sum / 1e3 / s.second.n
+       << setw(12) << s.second.max / 1e3 << endl;
+  }
+  if( !pads.empty() ) {
+    const size_t ntop = 10;
+    size_t n = min(ntop, pads.size());
+    partial_sort(pads.begin(), pads.begin() + n, pads.end(),
+                 []( const Event* a, const Event* b ) {
+                   return a->duration > b->duration;
+                 });
+    os << "  Slowest pads:" << endl;
+    for( size_t i = 0; i < n; ++i ) {
+      os << "    page " << pads[i]->page + 1 << " pad " << pads[i]->pad
+         << ": " << pads[i]->duration / 1e3 << " ms  "
+         << pads[i]->detail << endl;
+    }
+  }
+  os.flags(flags);
+  os.precision(prec);
+}
+
+//_____________________________________________________________________________
+int Profiler::WriteTrace( const string& filename ) const
+{
+  ofstream ofs(filename);
+  if( !ofs ) {
+    cerr << "ERROR: Cannot open profile file " << filename << endl;
+    return 1;
+  }
+  lock_guard<mutex> lock(fMutex);
+  ofs << fixed << setprecision(3)
+      << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  const char* sep = "";
+  for( const auto& ev: fEvents ) {
+    string label = ev.name;
+    if( !ev.detail.empty() )
+      label += ": " + ev.detail;
+    ofs << sep << endl
+        << "  {\"name\": " << JsonQuote(label)
+        << ", \"cat\": " << JsonQuote(ev.name)
+        << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ev.tid
+        << ", \"ts\": " << ev.start << ", \"dur\": " << ev.duration
+        << ", \"args\": {";
+    const char* asep = "";
+    if( ev.page >= 0 ) {
+      ofs << "\"page\": " << ev.page + 1;
+      asep = ", ";
+    }
+    if( ev.pad > 0 ) {
+      ofs << asep << "\"pad\": " << ev.pad;
+      asep = ", ";
+    }
+    if( !ev.detail.empty() )
+      ofs << asep << "\"detail\": " << JsonQuote(ev.detail);
+    ofs << "}}";
+    sep = ",";
+  }
+  ofs << endl << "]}" << endl;
+  return 0;
+}
+
+//_____________________________________________________________________________
+StartupTimer& StartupTimer::Instance()
+{
+  static StartupTimer instance;
+  return instance;
+}
+
+//_____________________________________________________________________________
+void StartupTimer::Enable()
+{
+  // CPU time used so far: loading and initializing the ROOT libraries
+  ProcInfo_t info;
+  if( gSystem->GetProcInfo(&info) == 0 )
+    fCpuBefore = info.fCpuUser + info.fCpuSys;
+  fT0 = fLast = chrono::steady_clock::now();
+  fStages.clear();
+  fReported = false;
+  fEnabled = true;
+}
+
+//_____________________________________________________________________________
+void StartupTimer::Mark( const char* stage )
+{
+  if( !fEnabled || fReported )
+    return;
+  auto now = chrono::steady_clock::now();
+  fStages.emplace_back(stage, chrono::duration<double>(now - fLast).count());
+  fLast = now;
+}
+
+//_____________________________________________________________________________
+void StartupTimer::Report( ostream& os )
+{
+  if( !fEnabled || fReported )
+    return;
+  fReported = true;
+  ios::fmtflags flags = os.flags();
+  streamsize prec = os.precision();
+  os << fixed << setprecision(3)
+     << "Startup timing:" << endl
+     << "  " << setw(9) << fCpuBefore << " s  before main (CPU time)" << endl;
+  for( const auto& stage: fStages )
+    os << "  " << setw(9) << stage.second << " s  " << stage.first << endl;
+  os << "  " << setw(9) << chrono::duration<double>(fLast - fT0).count()
+     << " s  total" << endl;
+  os.flags(flags);
+  os.precision(prec);
+}
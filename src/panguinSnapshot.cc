@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////
+//  HistSnapshot: persistent tree-draw results for finished runs
+///////////////////////////////////////////////////////////////////
+
+#include "panguinSnapshot.hh"
+#include <TFile.h>
+#include <TKey.h>
+#include <TList.h>
+#include <TNamed.h>
+#include <TH1.h>
+#include <iostream>
+#include <cstdio>
+
+using namespace std;
+
+const char* const HistSnapshot::kKeyName = "panguin_snapshot_key";
+
+//_____________________________________________________________________________
+HistSnapshot::HistSnapshot() = default;
+
+//_____________________________________________________________________________
+HistSnapshot::~HistSnapshot() = default;
+
+//_____________________________________________________________________________
+void HistSnapshot::Open( const string& filename, const string& key,
+                         bool write, int verbosity )
+{
+  Close();
+  fFileName = filename;
+  fKey = key;
+  fWrite = write;
+  fVerbosity = verbosity;
+  fNhit = 0;
+  if( fFileName.empty() )
+    return;
+
+  unique_ptr<TFile> file(TFile::Open(fFileName.c_str(), "READ"));
+  if( !file || !file->IsOpen() ) {
+    if( fVerbosity >= 1 )
+      cout << "No histogram snapshot " << fFileName << endl;
+    return;
+  }
+  TNamed* stored = nullptr;
+  file->GetObject(kKeyName, stored);
+  bool match = stored && fKey == stored->GetTitle();
+  delete stored;
+  if( !match ) {
+    cout << "Histogram snapshot " << fFileName
+         << " was made for a different configuration or input; not used"
+         << endl;
+    return;
+  }
+  cout << "Using histogram snapshot " << fFileName << endl;
+  fFile = std::move(file);
+}
+
+//_____________________________________________________________________________
+TH1* HistSnapshot::Get( const string& padid )
+{
+  if( !fFile )
+    return nullptr;
+  TH1* hist = nullptr;
+  fFile->GetObject(padid.c_str(), hist);
+  if( !hist )
+    return nullptr;
+  hist->SetDirectory(nullptr);
+  ++fNhit;
+  return hist;
+}
+
+//_____________________________________________________________________________
+void HistSnapshot::Put( const string& padid, const TH1* hist )
+{
+  if( !fWrite || !hist || !IsEnabled() )
+    return;
+  auto* copy = static_cast<TH1*>(hist->Clone());
+  copy->SetDirectory(nullptr);
+  fNew[padid].reset(copy);
+}
+
+//_____________________________________________________________________________
+int HistSnapshot::Close()
+{
+  if( !IsEnabled() )
+    return 0;
+  int ret = 0;
+  if( fVerbosity >= 1 || fNhit > 0 || !fNew.empty() )
+    cout << "Histogram snapshot " << fFileName << ": " << fNhit
+         << " pads loaded, " << fNew.size() << " pads added" << endl;
+  if( fWrite && !fNew.empty() ) {
+    // Write the new file next to the old one, carrying over the histograms
+    // of the old snapshot that were not drawn again, then replace it
+    string tmp = fFileName + ".tmp";
+    TFile out(tmp.c_str(), "RECREATE");
+    if( !out.IsOpen() ) {
+      cerr << "ERROR: Cannot create histogram snapshot " << tmp << endl;
+      ret = 1;
+    } else {
+      TNamed key(kKeyName, fKey.c_str());
+      out.WriteTObject(&key);
+      if( fFile ) {
+        TIter next(fFile->GetListOfKeys());
+        while( auto* k = static_cast<TKey*>(next()) ) {
+          string name = k->GetName();
+          if( name == kKeyName || fNew.find(name) != fNew.end() )
+            continue;
+          unique_ptr<TObject> obj(k->ReadObj());
+          if( obj )
+            out.WriteTObject(obj.get(), name.c_str());
+        }
+      }
+      for( const auto& entry: fNew )
+        out.WriteTObject(entry.second.get(), entry.first.c_str());
+      out.Close();
+      if( rename(tmp.c_str(), fFileName.c_str()) != 0 ) {
+        cerr << "ERROR: Cannot rename " << tmp << " to " << fFileName << endl;
+        ret = 1;
+      }
+    }
+  }
+  fFile.reset();
+  fNew.clear();
+  fFileName.clear();
+  fKey.clear();
+  fNhit = 0;
+  return ret;
+}
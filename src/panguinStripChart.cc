@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////
+//  StripChart: ring buffer of per-update metrics
+///////////////////////////////////////////////////////////////////
+
+#include "panguinStripChart.hh"
+#include <TGraph.h>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+StripChart::StripChart( size_t capacity )
+  : fTime(max(capacity, size_t(1)))
+  , fValue(fTime.size())
+{}
+
+//_____________________________________________________________________________
+void StripChart::Push( double time, double value )
+{
+  fTime[fNext] = time;
+  fValue[fNext] = value;
+  fNext = (fNext + 1) % fTime.size();
+  if( fSize < fTime.size() )
+    ++fSize;
+}
+
+//_____________________________________________________________________________
+void StripChart::Clear()
+{
+  fNext = fSize = 0;
+  fLastEntries = -1;
+  fLastTime = 0;
+}
+
+//_____________________________________________________________________________
+TGraph* StripChart::MakeGraph() const
+{
+  if( fSize == 0 )
+    return nullptr;
+  auto* graph = new TGraph(static_cast<Int_t>(fSize));
+  size_t first = (fNext + fTime.size() - fSize) % fTime.size();
+  for( size_t i = 0; i < fSize; ++i ) {
+    size_t k = (first + i) % fTime.size();
+    graph->SetPoint(static_cast<Int_t>(i), fTime[k], fValue[k]);
+  }
+  return graph;
+}
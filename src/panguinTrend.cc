@@ -0,0 +1,258 @@
+///////////////////////////////////////////////////////////////////
+//  TrendStore: per-run pad metrics across runs
+///////////////////////////////////////////////////////////////////
+
+#include "panguinTrend.hh"
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1.h>
+#include <TGraph.h>
+#include <TSystem.h>
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+static const char* const kTrendTree = "trend";
+static const int kMaxQuantiles = 20;
+
+//_____________________________________________________________________________
+// Branch buffers of the trend tree
+struct TrendRow {
+  Int_t run{0}, page{0}, pad{0};
+  Double_t entries{0}, mean{0}, rms{0}, integral{0};
+  Double_t underflow{0}, overflow{0};
+  Int_t nq{0};
+  Double_t qprob[kMaxQuantiles]{};
+  Double_t q[kMaxQuantiles]{};
+  string padid, name;
+  string* ppadid{&padid};
+  string* pname{&name};
+
+  void Branch( TTree* t )
+  {
+    t->Branch("run", &run, "run/I");
+    t->Branch("page", &page, "page/I");
+    t->Branch("pad", &pad, "pad/I");
+    t->Branch("padid", &padid);
+    t->Branch("name", &name);
+    t->Branch("entries", &entries, "entries/D");
+    t->Branch("mean", &mean, "mean/D");
+    t->Branch("rms", &rms, "rms/D");
+    t->Branch("integral", &integral, "integral/D");
+    t->Branch("underflow", &underflow, "underflow/D");
+    t->Branch("overflow", &overflow, "overflow/D");
+    t->Branch("nq", &nq, "nq/I");
+    t->Branch("qprob", qprob, "qprob[nq]/D");
+    t->Branch("q", q, "q[nq]/D");
+  }
+  void SetAddresses( TTree* t )
+  {
+    t->SetBranchAddress("run", &run);
+    t->SetBranchAddress("page", &page);
+    t->SetBranchAddress("pad", &pad);
+    t->SetBranchAddress("padid", &ppadid);
+    t->SetBranchAddress("name", &pname);
+    t->SetBranchAddress("entries", &entries);
+    t->SetBranchAddress("mean", &mean);
+    t->SetBranchAddress("rms", &rms);
+    t->SetBranchAddress("integral", &integral);
+    t->SetBranchAddress("underflow", &underflow);
+    t->SetBranchAddress("overflow", &overflow);
+    t->SetBranchAddress("nq", &nq);
+    t->SetBranchAddress("qprob", qprob);
+    t->SetBranchAddress("q", q);
+  }
+  void From( const TrendPoint& p )
+  {
+    run = p.run; page = p.page; pad = p.pad;
+    padid = p.padid; name = p.name;
+    entries = p.entries; mean = p.mean; rms = p.rms; integral = p.integral;
+    underflow = p.underflow; overflow = p.overflow;
+    nq = static_cast<Int_t>(min(p.q.size(), size_t(kMaxQuantiles)));
+    copy_n(p.qprob.begin(), nq, qprob);
+    copy_n(p.q.begin(), nq, q);
+  }
+  void To( TrendPoint& p ) const
+  {
+    p.run = run; p.page = page; p.pad = pad;
+    p.padid = padid; p.name = name;
+    p.entries = entries; p.mean = mean; p.rms = rms; p.integral = integral;
+    p.underflow = underflow; p.overflow = overflow;
+    int n = max(0, min(nq, kMaxQuantiles));
+    p.qprob.assign(qprob, qprob + n);
+    p.q.assign(q, q + n);
+  }
+};
+
+//_____________________________________________________________________________
+TrendStore::TrendStore()
+  : fQProb{0.1, 0.5, 0.9}
+{}
+
+//_____________________________________________________________________________
+void TrendStore::SetFile( const string& filename )
+{
+  if( filename == fFileName )
+    return;
+  fFileName = filename;
+  fPoints.clear();
+  fLoadedMtime = -1;
+  fLoadedSize = -1;
+}
+
+//_____________________________________________________________________________
+void TrendStore::Add( int run, int page, int pad, const string& padid,
+                      const string& name, const TH1* hist )
+{
+  if( !IsEnabled() || !hist )
+    return;
+  TrendPoint p;
+  p.run = run;
+  p.page = page;
+  p.pad = pad;
+  p.padid = padid;
+  p.name = name;
+  p.entries = hist->GetEntries();
+  p.mean = hist->GetMean(1);
+  p.rms = hist->GetRMS(1);
+  p.integral = hist->Integral();
+  if( hist->GetDimension() == 1 ) {
+    p.underflow = hist->GetBinContent(0);
+    p.overflow = hist->GetBinContent(hist->GetNbinsX() + 1);
+    if( p.integral > 0 && !fQProb.empty() ) {
+      p.qprob.assign(fQProb.begin(),
+                     fQProb.begin() + min(fQProb.size(), size_t(kMaxQuantiles)));
+      p.q.resize(p.qprob.size());
+      const_cast<TH1*>(hist)->GetQuantiles(
+        static_cast<Int_t>(p.q.size()), p.q.data(), p.qprob.data());
+    }
+  }
+  fPending.push_back(std::move(p));
+}
+
+//_____________________________________________________________________________
+int TrendStore::Flush()
+{
+  if( !IsEnabled() || fPending.empty() )
+    return 0;
+  TFile f(fFileName.c_str(), "UPDATE");
+  if( !f.IsOpen() ) {
+    cerr << "ERROR: Cannot open trend store " << fFileName << endl;
+    return 1;
+  }
+  TrendRow row;
+  TTree* tree = nullptr;
+  f.GetObject(kTrendTree, tree);
+  if( tree ) {
+    row.SetAddresses(tree);
+  } else {
+    f.cd();
+    tree = new TTree(kTrendTree, "panguin per-run pad metrics");
+    row.Branch(tree);
+  }
+  for( const auto& p: fPending ) {
+    row.From(p);
+    tree->Fill();
+  }
+  tree->Write("", TObject::kOverwrite);
+  f.Close();
+  cout << "Appended " << fPending.size() << " pad metrics to trend store "
+       << fFileName << endl;
+  fPending.clear();
+  return 0;
+}
+
+//_____________________________________________________________________________
+// (Re)read the store if the file changed since it was last read
+int TrendStore::Load()
+{
+  FileStat_t fs;
+  if( gSystem->GetPathInfo(fFileName.c_str(), fs) != 0 ) {
+    fPoints.clear();
+    fLoadedMtime = -1;
+    return 1;
+  }
+  if( fs.fMtime == fLoadedMtime && fs.fSize == fLoadedSize )
+    return 0;
+  fPoints.clear();
+  unique_ptr<TFile> f(TFile::Open(fFileName.c_str(), "READ"));
+  if( !f || !f->IsOpen() )
+    return 1;
+  TTree* tree = nullptr;
+  f->GetObject(kTrendTree, tree);
+  if( !tree )
+    return 1;
+  TrendRow row;
+  row.SetAddresses(tree);
+  Long64_t n = tree->GetEntries();
+  for( Long64_t i = 0; i < n; ++i ) {
+    tree->GetEntry(i);
+    // Later entries for the same run replace earlier ones
+    row.To(fPoints[row.padid][row.run]);
+  }
+  fLoadedMtime = fs.fMtime;
+  fLoadedSize = fs.fSize;
+  return 0;
+}
+
+//_____________________________________________________________________________
+bool TrendStore::GetMetric( const TrendPoint& p, const string& metric,
+                            double& value )
+{
+  if( metric == "entries" )        value = p.entries;
+  else if( metric == "mean" )      value = p.mean;
+  else if( metric == "rms" )       value = p.rms;
+  else if( metric == "integral" )  value = p.integral;
+  else if( metric == "underflow" ) value = p.underflow;
+  else if( metric == "overflow" )  value = p.overflow;
+  else if( metric.size() > 1 && metric[0] == 'q' ) {
+    double prob = atof(metric.c_str() + 1) / 100.;
+    for( size_t i = 0; i < p.qprob.size() && i < p.q.size(); ++i ) {
+      if( fabs(p.qprob[i] - prob) < 1e-6 ) {
+        value = p.q[i];
+        return true;
+      }
+    }
+    return false;
+  } else
+    return false;
+  return true;
+}
+
+//_____________________________________________________________________________
+TGraph* TrendStore::MakeGraph( const string& pad, const string& metric )
+{
+  if( !IsEnabled() || Load() != 0 )
+    return nullptr;
+  // By pad identity or, failing that, by name. If several pads draw the
+  // same variable, take the one processed most recently.
+  auto it = fPoints.find(pad);
+  if( it == fPoints.end() ) {
+    int lastrun = 0;
+    for( auto jt = fPoints.begin(); jt != fPoints.end(); ++jt ) {
+      const auto& runs = jt->second;
+      if( !runs.empty() && runs.rbegin()->second.name == pad &&
+          (it == fPoints.end() || runs.rbegin()->first > lastrun) ) {
+        it = jt;
+        lastrun = runs.rbegin()->first;
+      }
+    }
+    if( it == fPoints.end() )
+      return nullptr;
+  }
+  vector<double> x, y;
+  for( const auto& entry: it->second ) {
+    double value = 0;
+    if( GetMetric(entry.second, metric, value) ) {
+      x.push_back(entry.first);
+      y.push_back(value);
+    }
+  }
+  if( x.empty() )
+    return nullptr;
+  return new TGraph(static_cast<Int_t>(x.size()), x.data(), y.data());
+}